@@ -0,0 +1,304 @@
+/**
+ * Tracking throughput benchmark
+ *
+ * Frames are synthesized by rendering a generated box mesh at scripted poses
+ * (normal image as color, metric depth as 16-bit depth). They are then
+ * tracked through DummyColorCamera/DummyDepthCamera for region-only and
+ * region+depth tracking, with and without occlusion modelling, and for 1, 4,
+ * and 16 bodies. Frames per second, tracking errors, and per-stage latencies
+ * are reported.
+ *
+ * Usage: pyicg_tracking_benchmark [n_frames=100] [directory=benchmark_tmp]
+ *                                 [--rendering_backend glfw|egl|osmesa]
+ *
+ * Without --rendering_backend, the backend from PYICG_RENDERING_BACKEND or the
+ * build default is used, so the benchmark also runs without a display.
+ */
+
+#include <filesystem/filesystem.h>
+#include <icg/basic_depth_renderer.h>
+#include <icg/body.h>
+#include <icg/common.h>
+#include <icg/depth_modality.h>
+#include <icg/normal_renderer.h>
+#include <icg/optimizer.h>
+#include <icg/region_modality.h>
+#include <icg/renderer_geometry.h>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pyicg/dummy_camera.h"
+#include "pyicg/extended_tracker.h"
+#include "pyicg/rendering_backend.h"
+#include "pyicg/sequence_tracker.h"
+#include "pyicg/shared_model.h"
+
+using namespace icg;
+
+struct BenchmarkConfig {
+  bool use_depth;
+  bool model_occlusions;
+  int n_bodies;
+};
+
+struct SyntheticSequence {
+  std::vector<cv::Mat> color_images;
+  std::vector<cv::Mat> depth_images;
+  std::vector<std::vector<Transform3fA>> body2world_poses;  // per body, frame
+};
+
+constexpr float kDepthScale = 0.001f;
+const Intrinsics kIntrinsics{615.2f, 615.2f, 324.0f, 237.0f, 640, 480};
+
+// Asymmetric box of 10 x 6 x 4 cm, counterclockwise faces
+bool WriteBoxGeometry(const std::filesystem::path &path) {
+  std::ofstream ofs{path};
+  if (!ofs.is_open()) return false;
+  const float x = 0.05f, y = 0.03f, z = 0.02f;
+  for (int i = 0; i < 8; ++i)
+    ofs << "v " << (i & 1 ? x : -x) << " " << (i & 2 ? y : -y) << " "
+        << (i & 4 ? z : -z) << "\n";
+  ofs << "f 1 3 4\nf 1 4 2\nf 5 6 8\nf 5 8 7\nf 1 2 6\nf 1 6 5\n"
+         "f 3 7 8\nf 3 8 4\nf 1 5 7\nf 1 7 3\nf 2 4 8\nf 2 8 6\n";
+  return true;
+}
+
+std::shared_ptr<Body> CreateBody(const std::string &name,
+                                 const std::filesystem::path &geometry_path) {
+  return std::make_shared<Body>(name, geometry_path, 1.0f, true, true,
+                                Transform3fA::Identity());
+}
+
+// Bodies on a grid 60 cm in front of the camera, moving and rotating slowly
+Transform3fA ScriptedPose(int body_idx, int n_bodies, int frame) {
+  int n_columns = int(std::ceil(std::sqrt(float(n_bodies))));
+  float spacing = 0.12f;
+  float t = float(frame) / 30.0f;
+  Eigen::Vector3f translation{
+      (float(body_idx % n_columns) - 0.5f * float(n_columns - 1)) * spacing,
+      (float(body_idx / n_columns) - 0.5f * float(n_columns - 1)) * spacing,
+      0.6f};
+  translation += 0.01f * Eigen::Vector3f{std::sin(t), std::cos(t), 0.0f};
+  Transform3fA pose{Transform3fA::Identity()};
+  pose.translate(translation);
+  pose.rotate(Eigen::AngleAxisf{0.6f + 0.2f * t, Eigen::Vector3f::UnitY()});
+  pose.rotate(Eigen::AngleAxisf{0.4f, Eigen::Vector3f::UnitX()});
+  return pose;
+}
+
+std::shared_ptr<DummyColorCamera> CreateColorCamera() {
+  auto color_camera_ptr{std::make_shared<DummyColorCamera>("color_camera")};
+  color_camera_ptr->set_intrinsics(kIntrinsics);
+  color_camera_ptr->set_color2depth_pose(Transform3fA::Identity());
+  return color_camera_ptr;
+}
+
+std::shared_ptr<DummyDepthCamera> CreateDepthCamera() {
+  auto depth_camera_ptr{
+      std::make_shared<DummyDepthCamera>("depth_camera", true, kDepthScale)};
+  depth_camera_ptr->set_intrinsics(kIntrinsics);
+  depth_camera_ptr->set_depth2color_pose(Transform3fA::Identity());
+  return depth_camera_ptr;
+}
+
+bool SynthesizeSequence(int n_bodies, int n_frames,
+                        const std::filesystem::path &geometry_path,
+                        SyntheticSequence *sequence) {
+  auto renderer_geometry_ptr{
+      std::make_shared<RendererGeometry>("synthesis_geometry")};
+  std::vector<std::shared_ptr<Body>> body_ptrs;
+  for (int i = 0; i < n_bodies; ++i) {
+    body_ptrs.push_back(
+        CreateBody("synthesis_body_" + std::to_string(i), geometry_path));
+    if (!body_ptrs.back()->SetUp()) return false;
+    renderer_geometry_ptr->AddBody(body_ptrs.back());
+  }
+  if (!renderer_geometry_ptr->SetUp()) return false;
+
+  auto camera_ptr{CreateColorCamera()};
+  if (!camera_ptr->SetUp()) return false;
+  FullNormalRenderer normal_renderer{"synthesis_normal_renderer",
+                                     renderer_geometry_ptr, camera_ptr};
+  FullBasicDepthRenderer depth_renderer{"synthesis_depth_renderer",
+                                        renderer_geometry_ptr, camera_ptr};
+  if (!normal_renderer.SetUp() || !depth_renderer.SetUp()) return false;
+
+  sequence->body2world_poses.assign(n_bodies, {});
+  for (int frame = 0; frame < n_frames; ++frame) {
+    for (int i = 0; i < n_bodies; ++i) {
+      Transform3fA pose{ScriptedPose(i, n_bodies, frame)};
+      body_ptrs[i]->set_body2world_pose(pose);
+      sequence->body2world_poses[i].push_back(pose);
+    }
+    if (!normal_renderer.StartRendering() ||
+        !normal_renderer.FetchNormalImage() ||
+        !depth_renderer.StartRendering() || !depth_renderer.FetchDepthImage())
+      return false;
+
+    cv::Mat color_image;
+    cv::cvtColor(normal_renderer.normal_image(), color_image,
+                 cv::COLOR_BGRA2BGR);
+    cv::Mat depth_image{kIntrinsics.height, kIntrinsics.width, CV_16UC1};
+    for (int v = 0; v < depth_image.rows; ++v) {
+      for (int u = 0; u < depth_image.cols; ++u) {
+        float depth = depth_renderer.Depth(cv::Point2i{u, v});
+        depth_image.at<ushort>(v, u) =
+            depth < 4.9f ? ushort(depth / kDepthScale) : ushort(0);
+      }
+    }
+    sequence->color_images.push_back(color_image);
+    sequence->depth_images.push_back(depth_image);
+  }
+  return true;
+}
+
+bool RunBenchmark(const BenchmarkConfig &config,
+                  const SyntheticSequence &sequence,
+                  const std::filesystem::path &directory,
+                  const std::filesystem::path &geometry_path) {
+  auto tracker_ptr{std::make_shared<ExtendedTracker>("tracker", 5, 2, false)};
+  auto renderer_geometry_ptr{
+      std::make_shared<RendererGeometry>("renderer_geometry")};
+  auto color_camera_ptr{CreateColorCamera()};
+  auto depth_camera_ptr{CreateDepthCamera()};
+
+  std::shared_ptr<FocusedBasicDepthRenderer> color_depth_renderer_ptr;
+  std::shared_ptr<FocusedBasicDepthRenderer> depth_depth_renderer_ptr;
+  if (config.model_occlusions) {
+    color_depth_renderer_ptr = std::make_shared<FocusedBasicDepthRenderer>(
+        "color_depth_renderer", renderer_geometry_ptr, color_camera_ptr);
+    depth_depth_renderer_ptr = std::make_shared<FocusedBasicDepthRenderer>(
+        "depth_depth_renderer", renderer_geometry_ptr, depth_camera_ptr);
+  }
+
+  std::vector<std::shared_ptr<Body>> body_ptrs;
+  for (int i = 0; i < config.n_bodies; ++i) {
+    std::string name{"body_" + std::to_string(i)};
+    auto body_ptr{CreateBody(name, geometry_path)};
+    body_ptr->set_body2world_pose(sequence.body2world_poses[i][0]);
+    renderer_geometry_ptr->AddBody(body_ptr);
+    body_ptrs.push_back(body_ptr);
+
+    // Models are shared by all bodies and configurations
+    auto region_model_ptr{SharedRegionModel::Get(
+        "region_model", body_ptr, directory / "box_region_model.bin")};
+    auto depth_model_ptr{SharedDepthModel::Get(
+        "depth_model", body_ptr, directory / "box_depth_model.bin")};
+
+    auto region_modality_ptr{std::make_shared<RegionModality>(
+        name + "_region_modality", body_ptr, color_camera_ptr,
+        region_model_ptr)};
+    auto optimizer_ptr{std::make_shared<Optimizer>(name + "_optimizer")};
+    optimizer_ptr->AddModality(region_modality_ptr);
+    if (config.use_depth) {
+      auto depth_modality_ptr{std::make_shared<DepthModality>(
+          name + "_depth_modality", body_ptr, depth_camera_ptr,
+          depth_model_ptr)};
+      optimizer_ptr->AddModality(depth_modality_ptr);
+      if (config.model_occlusions) {
+        depth_depth_renderer_ptr->AddReferencedBody(body_ptr);
+        depth_modality_ptr->ModelOcclusions(depth_depth_renderer_ptr);
+      }
+    }
+    if (config.model_occlusions) {
+      color_depth_renderer_ptr->AddReferencedBody(body_ptr);
+      region_modality_ptr->ModelOcclusions(color_depth_renderer_ptr);
+    }
+    tracker_ptr->AddOptimizer(optimizer_ptr);
+  }
+  if (!tracker_ptr->SetUp()) return false;
+
+  SequenceTracker sequence_tracker{
+      "sequence_tracker", tracker_ptr, color_camera_ptr,
+      config.use_depth ? depth_camera_ptr : nullptr};
+  if (!sequence_tracker.SetUp()) return false;
+  std::vector<std::vector<Transform3fA>> body2world_poses;
+  const std::vector<cv::Mat> no_images;
+  auto begin{std::chrono::steady_clock::now()};
+  if (!sequence_tracker.TrackSequence(
+          sequence.color_images,
+          config.use_depth ? sequence.depth_images : no_images,
+          &body2world_poses))
+    return false;
+  float duration = std::chrono::duration<float>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+
+  // Mean translation error over all bodies and frames
+  float error = 0.0f;
+  int n_frames = int(sequence.color_images.size());
+  for (int i = 0; i < config.n_bodies; ++i) {
+    for (int frame = 0; frame < n_frames; ++frame) {
+      error += (body2world_poses[i][frame].translation() -
+                sequence.body2world_poses[i][frame].translation())
+                   .norm();
+    }
+  }
+  error /= float(config.n_bodies * n_frames);
+
+  std::cout << std::fixed << std::setprecision(2)
+            << (config.use_depth ? "region+depth" : "region      ")
+            << (config.model_occlusions ? " occlusions   " : " no_occlusions")
+            << " bodies " << std::setw(2) << config.n_bodies << ": "
+            << std::setw(7) << float(n_frames) / duration << " frames/s, "
+            << "translation error " << error * 1000.0f << " mm" << std::endl;
+  for (const auto &statistics : tracker_ptr->ComputeLatencyStatistics()) {
+    if (statistics.count == 0) continue;
+    std::cout << "    " << std::left << std::setw(48) << statistics.stage
+              << std::right << " p50 " << std::setw(7) << statistics.p50
+              << " ms, p99 " << std::setw(7) << statistics.p99 << " ms"
+              << std::endl;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  RenderingBackend backend = DefaultRenderingBackend();
+  std::vector<std::string> positional_args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if (arg == "--rendering_backend") {
+      if (++i == argc || !ParseRenderingBackend(argv[i], &backend)) return 1;
+    } else {
+      positional_args.push_back(arg);
+    }
+  }
+  // Has to be applied before the first RendererGeometry is set up
+  if (!SetRenderingBackend(backend)) return 1;
+
+  int n_frames =
+      positional_args.size() > 0 ? std::stoi(positional_args[0]) : 100;
+  std::filesystem::path directory{
+      positional_args.size() > 1 ? positional_args[1] : "benchmark_tmp"};
+  std::filesystem::create_directories(directory);
+  std::filesystem::path geometry_path{directory / "box.obj"};
+  if (!WriteBoxGeometry(geometry_path)) {
+    std::cerr << "Could not write " << geometry_path << std::endl;
+    return 1;
+  }
+
+  for (int n_bodies : {1, 4, 16}) {
+    SyntheticSequence sequence;
+    if (!SynthesizeSequence(n_bodies, n_frames, geometry_path, &sequence)) {
+      std::cerr << "Could not synthesize sequence" << std::endl;
+      return 1;
+    }
+    for (bool use_depth : {false, true}) {
+      for (bool model_occlusions : {false, true}) {
+        BenchmarkConfig config{use_depth, model_occlusions, n_bodies};
+        if (!RunBenchmark(config, sequence, directory, geometry_path)) {
+          std::cerr << "Benchmark failed" << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef ICG_INCLUDE_ICG_allocation_counter_H_
+#define ICG_INCLUDE_ICG_allocation_counter_H_
+
+#include <cstdint>
+
+namespace icg {
+
+// Number of calls to the global operator new since the start of the process,
+// or -1 if pyicg was built without COUNT_ALLOCATIONS. Allocations of shared
+// libraries that do not use operator new, e.g. OpenCV image buffers, are not
+// counted.
+int64_t AllocationCount();
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_allocation_counter_H_
@@ -0,0 +1,115 @@
+
+#ifndef ICG_INCLUDE_ICG_bounded_queue_H_
+#define ICG_INCLUDE_ICG_bounded_queue_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace icg {
+
+/**
+ * \brief Thread-safe FIFO queue holding at most `capacity` items, used to
+ * connect stages of a pipeline.
+ *
+ * When the queue is full, `Push()` either drops the oldest item (which is
+ * handed back to the caller) or blocks until an item is popped. After
+ * `Close()`, pushing fails and popping returns remaining items, then fails.
+ *
+ * @param capacity maximum number of items, at least 1.
+ * @param drop_oldest drop the oldest item instead of blocking when full.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  // Constructor
+  explicit BoundedQueue(int capacity = 2, bool drop_oldest = true)
+      : capacity_{capacity < 1 ? size_t(1) : size_t(capacity)},
+        drop_oldest_{drop_oldest} {}
+
+  // Returns false if the queue is closed. *dropped is set to true if the
+  // oldest item was moved to dropped_item to make room.
+  bool Push(T &&item, T *dropped_item = nullptr, bool *dropped = nullptr) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (dropped) *dropped = false;
+    if (!drop_oldest_)
+      not_full_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+    if (closed_) return false;
+    if (items_.size() >= capacity_) {
+      if (dropped_item) *dropped_item = std::move(items_.front());
+      if (dropped) *dropped = true;
+      items_.pop_front();
+      n_dropped_++;
+    }
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Waits at most timeout for an item, returns false if none was popped
+  bool Pop(T *item, const std::chrono::milliseconds &timeout) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (!not_empty_.wait_for(lock, timeout,
+                             [&] { return closed_ || !items_.empty(); }))
+      return false;
+    return PopLocked(item);
+  }
+
+  // Waits until an item is available or the queue is closed
+  bool Pop(T *item) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    not_empty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+    return PopLocked(item);
+  }
+
+  void Close() {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  // Reopens an empty queue
+  void Reset() {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    items_.clear();
+    closed_ = false;
+    n_dropped_ = 0;
+  }
+
+  // Getters
+  size_t size() const {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    return items_.size();
+  }
+  size_t n_dropped() const {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    return n_dropped_;
+  }
+  size_t capacity() const { return capacity_; }
+  bool drop_oldest() const { return drop_oldest_; }
+
+ private:
+  bool PopLocked(T *item) {
+    if (items_.empty()) return false;
+    *item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  // Data
+  size_t capacity_;
+  bool drop_oldest_;
+  std::deque<T> items_;
+  size_t n_dropped_ = 0;
+  bool closed_ = false;
+  mutable std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_bounded_queue_H_
@@ -8,8 +8,16 @@
 
 #include <chrono>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "pyicg/image_prefetcher.h"
+#include "pyicg/image_roi.h"
+#include "pyicg/recording.h"
+#include "pyicg/shm_frame_ring.h"
 
 namespace icg {
 
@@ -17,6 +25,13 @@ namespace icg {
 /**
  * \brief \ref Camera that implements trivial implementations of ColorCamera
  *
+ * If a \ref RecordingWriter is set, `UpdateImage()` adds the image to it.
+ *
+ * With an `image_scale` below 1 or bodies added with `AddRoiBody()`,
+ * `UpdateImage()` replaces the sensor image by the output of an \ref ImageRoi:
+ * only a region of interest around the bodies is resized and copied, and
+ * `intrinsics` are the scaled `sensor_intrinsics`.
+ *
  * @param use_depth_as_world_frame specifies the depth camera frame as world
  * frame and automatically defines `camera2world_pose` as `color2depth_pose`.
  */
@@ -36,6 +51,13 @@ class DummyColorCamera : public ColorCamera {
   void set_intrinsics(const Intrinsics& intr);
   void set_color2depth_pose(const Transform3fA & color2depth_pose);
   void set_depth2color_pose(const Transform3fA & depth2color_pose);
+  void set_recording_writer_ptr(
+      const std::shared_ptr<RecordingWriter> &recording_writer_ptr);
+  void set_image_scale(float image_scale);
+  void set_roi_margin(int roi_margin);
+  bool AddRoiBody(const std::shared_ptr<Body> &body_ptr);
+  bool DeleteRoiBody(const std::string &name);
+  void ClearRoiBodies();
 
 
   // Main method -> does nothing in this implementation
@@ -44,17 +66,26 @@ class DummyColorCamera : public ColorCamera {
   // Getters
   bool use_depth_as_world_frame() const;
   const Intrinsics& get_intrinsics() const;
+  const Intrinsics &sensor_intrinsics() const;
+  const ImageRoi &image_roi() const;
   const Transform3fA& get_color2depth_pose() const;
   const Transform3fA& get_depth2color_pose() const;
+  const std::shared_ptr<RecordingWriter> &recording_writer_ptr() const;
 
  private:
   // Helper methods
   bool LoadMetaData();
+  bool ProcessRoi();
 
   // Data
   bool use_depth_as_world_frame_ = false;
   bool initial_set_up_ = false;
   bool extrinsics_set_ = false;
+  std::shared_ptr<RecordingWriter> recording_writer_ptr_;
+  Intrinsics sensor_intrinsics_{};
+  ImageRoi image_roi_;
+  cv::Mat sensor_image_;
+  const uchar *roi_image_data_ = nullptr;
 
   // extrinsics
   Transform3fA color2depth_pose_{Transform3fA::Identity()};
@@ -65,6 +96,13 @@ class DummyColorCamera : public ColorCamera {
  * \brief \ref Camera that allows getting depth images from a \ref Trivial
  * camera.
  *
+ * Images are either `CV_16U` in units of `depth_scale` metres, used as is, or
+ * `CV_32F` in metres, converted once per frame with `depth_scale` into a
+ * reused `CV_16U` buffer (0 for invalid, NaN, or negative depth). If a
+ * \ref RecordingWriter is set, `UpdateImage()` adds the image to it. Images
+ * are scaled and cropped to a region of interest as in \ref DummyColorCamera,
+ * `CV_32F` images being converted within the region only.
+ *
  * @param use_color_as_world_frame specifies the color camera frame as world
  * frame and automatically defines `camera2world_pose` as `depth2color_pose`.
  */
@@ -86,6 +124,13 @@ class DummyDepthCamera : public DepthCamera {
   void set_color2depth_pose(const Transform3fA & color2depth_pose);
   void set_depth2color_pose(const Transform3fA & depth2color_pose);
   void set_depth_scale(float depth_scale);
+  void set_recording_writer_ptr(
+      const std::shared_ptr<RecordingWriter> &recording_writer_ptr);
+  void set_image_scale(float image_scale);
+  void set_roi_margin(int roi_margin);
+  bool AddRoiBody(const std::shared_ptr<Body> &body_ptr);
+  bool DeleteRoiBody(const std::string &name);
+  void ClearRoiBodies();
 
   // Main method -> does nothing in this implementation
   bool UpdateImage(bool synchronized) override;
@@ -93,22 +138,247 @@ class DummyDepthCamera : public DepthCamera {
   // Getters
   bool use_color_as_world_frame() const;
   const Intrinsics& get_intrinsics() const;
+  const Intrinsics &sensor_intrinsics() const;
+  const ImageRoi &image_roi() const;
   const Transform3fA& get_color2depth_pose() const;
   const Transform3fA& get_depth2color_pose() const;
+  const std::shared_ptr<RecordingWriter> &recording_writer_ptr() const;
 
  private:
   // Helper methods
   bool LoadMetaData();
+  bool ProcessRoi();
 
   bool use_color_as_world_frame_ = true;
   bool initial_set_up_ = false;
   bool extrinsics_set_ = false;
+  cv::Mat converted_image_;
+  std::shared_ptr<RecordingWriter> recording_writer_ptr_;
+  Intrinsics sensor_intrinsics_{};
+  ImageRoi image_roi_;
+  cv::Mat sensor_image_;
+  const uchar *roi_image_data_ = nullptr;
 
   // extrinsics
   Transform3fA color2depth_pose_{Transform3fA::Identity()};
   Transform3fA depth2color_pose_{Transform3fA::Identity()};
 };
 
+/**
+ * \brief \ref DummyColorCamera whose `UpdateImage()` advances through a
+ * sequence of image files, decoded ahead of time on background threads.
+ *
+ * Images are the files of `image_directory` whose names start with
+ * `image_prefix`, in lexicographic order, or the ones set with
+ * `set_image_paths()`. `SetUp()` restarts the sequence from the first image.
+ * `UpdateImage()` returns false once all images were read.
+ *
+ * @param n_decode_threads number of threads decoding images.
+ * @param prefetch_capacity maximum number of images decoded in advance.
+ */
+class ImageSequenceColorCamera : public DummyColorCamera {
+ public:
+  // Constructor and setup method
+  ImageSequenceColorCamera(const std::string &name,
+                           const std::filesystem::path &image_directory,
+                           const std::string &image_prefix = "bgr",
+                           bool use_depth_as_world_frame = false,
+                           int n_decode_threads = 2,
+                           int prefetch_capacity = 8);
+  bool SetUp() override;
+
+  // Setters
+  void set_image_paths(const std::vector<std::filesystem::path> &image_paths);
+
+  // Main method
+  bool UpdateImage(bool synchronized) override;
+
+  // Getters
+  const std::vector<std::filesystem::path> &image_paths() const;
+  int index() const;
+
+ private:
+  std::filesystem::path image_directory_;
+  std::string image_prefix_;
+  std::vector<std::filesystem::path> image_paths_;
+  bool image_paths_set_ = false;
+  int index_ = -1;
+  ImagePrefetcher prefetcher_;
+};
+
+/**
+ * \brief \ref DummyDepthCamera whose `UpdateImage()` advances through a
+ * sequence of 16-bit depth image files, decoded ahead of time on background
+ * threads.
+ *
+ * Same behavior as \ref ImageSequenceColorCamera.
+ */
+class ImageSequenceDepthCamera : public DummyDepthCamera {
+ public:
+  // Constructor and setup method
+  ImageSequenceDepthCamera(const std::string &name,
+                           const std::filesystem::path &image_directory,
+                           const std::string &image_prefix = "depth",
+                           bool use_color_as_world_frame = true,
+                           float depth_scale = 0.001f,
+                           int n_decode_threads = 2,
+                           int prefetch_capacity = 8);
+  bool SetUp() override;
+
+  // Setters
+  void set_image_paths(const std::vector<std::filesystem::path> &image_paths);
+
+  // Main method
+  bool UpdateImage(bool synchronized) override;
+
+  // Getters
+  const std::vector<std::filesystem::path> &image_paths() const;
+  int index() const;
+
+ private:
+  std::filesystem::path image_directory_;
+  std::string image_prefix_;
+  std::vector<std::filesystem::path> image_paths_;
+  bool image_paths_set_ = false;
+  int index_ = -1;
+  ImagePrefetcher prefetcher_;
+};
+
+/**
+ * \brief \ref DummyColorCamera whose `UpdateImage()` serves the next color
+ * image of a recording, without copy, from a \ref RecordingReader.
+ *
+ * Intrinsics and `color2depth_pose` are taken from the recording in `SetUp()`,
+ * which restarts from the first frame. `set_next_frame()` seeks. The camera
+ * holds the mapping of its current image, which therefore stays valid if the
+ * reader is closed.
+ */
+class RecordingColorCamera : public DummyColorCamera {
+ public:
+  // Constructor and setup method
+  RecordingColorCamera(
+      const std::string &name,
+      const std::shared_ptr<RecordingReader> &recording_reader_ptr,
+      bool use_depth_as_world_frame = false);
+  bool SetUp() override;
+
+  // Setters
+  void set_next_frame(int next_frame);
+
+  // Main method
+  bool UpdateImage(bool synchronized) override;
+
+  // Getters
+  const std::shared_ptr<RecordingReader> &recording_reader_ptr() const;
+  int index() const;
+
+ private:
+  std::shared_ptr<RecordingReader> recording_reader_ptr_;
+  std::shared_ptr<const uint8_t> mapping_ptr_;  // keeps image_ valid
+  int next_frame_ = 0;
+  int index_ = -1;
+};
+
+/**
+ * \brief \ref DummyDepthCamera whose `UpdateImage()` serves the next depth
+ * image of a recording, without copy, from a \ref RecordingReader.
+ *
+ * Same behavior as \ref RecordingColorCamera, `depth_scale` is also taken
+ * from the recording.
+ */
+class RecordingDepthCamera : public DummyDepthCamera {
+ public:
+  // Constructor and setup method
+  RecordingDepthCamera(
+      const std::string &name,
+      const std::shared_ptr<RecordingReader> &recording_reader_ptr,
+      bool use_color_as_world_frame = true);
+  bool SetUp() override;
+
+  // Setters
+  void set_next_frame(int next_frame);
+
+  // Main method
+  bool UpdateImage(bool synchronized) override;
+
+  // Getters
+  const std::shared_ptr<RecordingReader> &recording_reader_ptr() const;
+  int index() const;
+
+ private:
+  std::shared_ptr<RecordingReader> recording_reader_ptr_;
+  std::shared_ptr<const uint8_t> mapping_ptr_;  // keeps image_ valid
+  int next_frame_ = 0;
+  int index_ = -1;
+};
+
+/**
+ * \brief \ref DummyColorCamera whose `UpdateImage()` serves, without copy,
+ * the latest BGR8 frame published by another process in a \ref ShmFrameRing.
+ *
+ * The slot of the current image is held until the next `UpdateImage()`. With
+ * `synchronized`, `UpdateImage()` waits at most `timeout` for a frame newer
+ * than the current one, otherwise it returns the latest frame.
+ *
+ * @param shm_name name of the shared memory object created by the producer.
+ */
+class ShmColorCamera : public DummyColorCamera {
+ public:
+  // Constructor and setup method
+  ShmColorCamera(const std::string &name, const std::string &shm_name,
+                 bool use_depth_as_world_frame = false,
+                 const std::chrono::milliseconds &timeout =
+                     std::chrono::milliseconds{1000});
+  bool SetUp() override;
+
+  // Main method
+  bool UpdateImage(bool synchronized) override;
+
+  // Getters
+  const std::string &shm_name() const;
+  uint64_t frame_index() const;
+  int64_t timestamp_ns() const;
+
+ private:
+  ShmFrameRing ring_;
+  std::chrono::milliseconds timeout_;
+  uint64_t frame_index_ = 0;
+  int64_t timestamp_ns_ = 0;
+  bool has_frame_ = false;
+};
+
+/**
+ * \brief \ref DummyDepthCamera whose `UpdateImage()` serves, without copy,
+ * the latest U16 frame published by another process in a \ref ShmFrameRing.
+ *
+ * Same behavior as \ref ShmColorCamera.
+ */
+class ShmDepthCamera : public DummyDepthCamera {
+ public:
+  // Constructor and setup method
+  ShmDepthCamera(const std::string &name, const std::string &shm_name,
+                 bool use_color_as_world_frame = true,
+                 float depth_scale = 0.001f,
+                 const std::chrono::milliseconds &timeout =
+                     std::chrono::milliseconds{1000});
+  bool SetUp() override;
+
+  // Main method
+  bool UpdateImage(bool synchronized) override;
+
+  // Getters
+  const std::string &shm_name() const;
+  uint64_t frame_index() const;
+  int64_t timestamp_ns() const;
+
+ private:
+  ShmFrameRing ring_;
+  std::chrono::milliseconds timeout_;
+  uint64_t frame_index_ = 0;
+  int64_t timestamp_ns_ = 0;
+  bool has_frame_ = false;
+};
+
 }  // namespace icg
 
 #endif  // ICG_INCLUDE_ICG_dummy_camera_H_
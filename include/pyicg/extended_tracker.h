@@ -0,0 +1,269 @@
+
+#ifndef ICG_INCLUDE_ICG_extended_tracker_H_
+#define ICG_INCLUDE_ICG_extended_tracker_H_
+
+#include <filesystem/filesystem.h>
+#include <icg/common.h>
+#include <icg/depth_modality.h>
+#include <icg/depth_renderer.h>
+#include <icg/modality.h>
+#include <icg/optimizer.h>
+#include <icg/region_modality.h>
+#include <icg/renderer.h>
+#include <icg/tracker.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pyicg/dummy_camera.h"
+#include "pyicg/latency_recorder.h"
+#include "pyicg/pose_predictor.h"
+#include "pyicg/thread_pool.h"
+
+namespace icg {
+
+/**
+ * \brief \ref Tracker whose tracking cycle is executed step by step in pyicg,
+ * measuring the latency of every stage.
+ *
+ * `ExecuteTrackingCycle()` performs the same steps as the one of \ref Tracker
+ * but calls renderers, modalities, and optimizers individually. Latencies of
+ * camera updates, occlusion rendering, correspondences, gradient and hessian
+ * (per modality), optimization (per optimizer), results, viewers, and of the
+ * whole cycle are kept in a \ref LatencyRecorder. Each call of a stage is one
+ * sample, e.g. `n_corr_iterations` correspondence samples per cycle.
+ *
+ * With `n_threads > 1`, correspondences, gradients and hessians, and results
+ * of all modalities, including the ones of a single optimizer (e.g. region
+ * and depth), are computed concurrently, followed by the optimizations of
+ * different optimizers. Optimizers sum gradients and hessians of their
+ * modalities in a fixed order once all of them are computed, and every
+ * modality and optimizer is processed by a single thread, so results do not
+ * depend on `n_threads`. Renderers are still started, and their depth images
+ * fetched, on the calling thread before modalities read them. Optimizers that
+ * share a body are optimized serially.
+ *
+ * With `rerender_threshold > 0`, a \ref FocusedDepthRenderer is only started
+ * again if one of its referenced bodies moved, relative to its camera, by
+ * more than `rerender_threshold` pixels since its last rendering. Motion is
+ * bounded by the translation and the rotation of the bounding sphere of the
+ * body, projected at its depth. Otherwise the previous image is reused.
+ *
+ * With convergence thresholds, iterations adapt to the motion of each
+ * optimizer: its update iterations stop once a pose update rotates every body
+ * by less than `convergence_rotation` and translates it by less than
+ * `convergence_translation`, or once the norm of the summed gradient of its
+ * modalities changed by less than the fraction `convergence_gradient`. If
+ * this already happens in the first update after new correspondences, the
+ * optimizer is converged for the cycle and its modalities are skipped until
+ * the results. `n_corr_iterations` and `n_update_iterations` are caps, the
+ * iterations used in the last cycle are kept per optimizer.
+ *
+ * With `image_rois`, `SetUp()` adds the body of every region and depth
+ * modality to the region of interest of its camera, if the camera is a
+ * \ref DummyColorCamera or \ref DummyDepthCamera. The margin of color cameras
+ * is raised to cover the correspondence lines of the region modalities at
+ * their largest scale, since pixels outside of the region are 0.
+ *
+ * Added \ref PosePredictor objects extrapolate the poses of their bodies at
+ * the start of every `ExecuteTrackingCycle()` and are updated with the
+ * tracked poses after the results.
+ *
+ * Methods hide the ones of \ref Tracker, objects using the tracker have to
+ * call them on an `ExtendedTracker`. `RunTrackerProcess()` is not measured.
+ *
+ * @param measure_latencies records stage latencies (enabled by default).
+ * @param latency_capacity number of samples kept per stage.
+ * @param n_threads threads of the tracking cycle, 1 (default) is serial.
+ * @param rerender_threshold maximum motion in pixels for which occlusion
+ * renderings are reused, 0 (default) renders every time.
+ * @param convergence_rotation rotation in radians below which an update is
+ * converged, 0 (default) disables the criterion.
+ * @param convergence_translation translation in meter below which an update
+ * is converged, 0 (default) disables the criterion.
+ * @param convergence_gradient relative change of the gradient norm below
+ * which an update is converged, 0 (default) disables the criterion.
+ * @param image_rois restricts camera images to the tracked bodies.
+ */
+class ExtendedTracker : public Tracker {
+ public:
+  // Constructors and setup method
+  ExtendedTracker(const std::string &name, int n_corr_iterations = 5,
+                  int n_update_iterations = 2, bool synchronize_cameras = true,
+                  const std::chrono::milliseconds &cycle_duration =
+                      std::chrono::milliseconds{33},
+                  int visualization_time = 0, int viewer_time = 1);
+  ExtendedTracker(const std::string &name,
+                  const std::filesystem::path &metafile_path);
+  bool SetUp(bool set_up_all_objects = true);
+
+  // Setters
+  void set_measure_latencies(bool measure_latencies);
+  void set_latency_capacity(int latency_capacity);
+  void set_n_threads(int n_threads);
+  void set_rerender_threshold(float rerender_threshold);
+  void set_convergence_rotation(float convergence_rotation);
+  void set_convergence_translation(float convergence_translation);
+  void set_convergence_gradient(float convergence_gradient);
+  void set_image_rois(bool image_rois);
+
+  // Configure pose predictors
+  bool AddPosePredictor(
+      const std::shared_ptr<PosePredictor> &pose_predictor_ptr);
+  bool DeletePosePredictor(const std::string &name);
+  void ClearPosePredictors();
+
+  // Individual steps of the tracker process
+  bool UpdateCameras(bool update_all_cameras);
+  bool StartModalities(int iteration);
+  bool ExecuteTrackingCycle(int iteration);
+  bool UpdateViewers(int iteration);
+
+  // Latency measurements
+  std::vector<LatencyRecorder::Statistics> ComputeLatencyStatistics() const;
+  void ResetLatencies();
+
+  // Getters
+  bool measure_latencies() const;
+  int latency_capacity() const;
+  int n_threads() const;
+  float rerender_threshold() const;
+  int n_renderings() const;
+  int n_skipped_renderings() const;
+  float convergence_rotation() const;
+  float convergence_translation() const;
+  float convergence_gradient() const;
+  bool image_rois() const;
+  const std::vector<int> &used_corr_iterations() const;
+  const std::vector<int> &used_update_iterations() const;
+  const LatencyRecorder &latency_recorder() const;
+  const std::vector<std::shared_ptr<PosePredictor>> &pose_predictor_ptrs()
+      const;
+
+ private:
+  // Helper methods
+  void AssembleStepObjectPtrs();
+  void AddLatencyStages();
+  void AddRoiBodies();
+  bool StartRenderers(
+      const std::vector<std::shared_ptr<Renderer>> &renderer_ptrs);
+  bool RenderingRequired(const std::shared_ptr<Renderer> &renderer_ptr);
+  bool FetchDepthImages(
+      const std::vector<std::shared_ptr<Renderer>> &renderer_ptrs);
+
+  // Convergence of optimizers within a tracking cycle
+  bool adaptive_iterations() const;
+  void StartConvergenceChecks();
+  void StartCorrespondenceIteration();
+  bool OptimizerActive(int optimizer_idx) const;
+  bool ModalityActive(int modality_idx) const;
+  bool AllOptimizersConverged() const;
+  void StartUpdate(int optimizer_idx);
+  void FinishUpdate(int optimizer_idx, bool first_update);
+
+  // Run task for every modality or optimizer index, in parallel if possible.
+  // Templates, so that tasks capturing the cycle state are not copied into
+  // heap-allocated std::function objects every iteration
+  template <typename Task>
+  bool ForEachModality(Task &&task) {
+    return ForEach(int(cycle_modality_ptrs_.size()), true, task);
+  }
+
+  template <typename Task>
+  bool ForEachOptimizer(Task &&task) {
+    return ForEach(int(optimizer_ptrs().size()), optimizers_independent_,
+                   task);
+  }
+
+  template <typename Task>
+  bool ForEach(int n_tasks, bool parallel, Task &&task) {
+    if (!thread_pool_ || !parallel) {
+      for (int i = 0; i < n_tasks; ++i) {
+        if (!task(i)) return false;
+      }
+      return true;
+    }
+    task_results_.assign(n_tasks, false);
+    thread_pool_->ParallelFor(n_tasks,
+                              [&](int i) { task_results_[i] = task(i); });
+    return std::all_of(begin(task_results_), end(task_results_),
+                       [](char result) { return result; });
+  }
+
+  // Runs a step and records its duration in the given stage
+  template <typename Step>
+  bool MeasureStage(int stage_idx, Step &&step) {
+    if (!measure_latencies_) return step();
+    auto begin{std::chrono::steady_clock::now()};
+    bool result = step();
+    latency_recorder_.Record(
+        stage_idx, std::chrono::duration<float, std::milli>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count());
+    return result;
+  }
+
+  // Objects of the tracking cycle
+  std::vector<std::shared_ptr<Modality>> cycle_modality_ptrs_;
+  std::vector<std::shared_ptr<Renderer>> cycle_correspondence_renderer_ptrs_;
+  std::vector<std::shared_ptr<Renderer>> cycle_results_renderer_ptrs_;
+  bool optimizers_independent_ = true;
+  std::vector<std::vector<int>> modality_optimizer_idxs_;
+  std::vector<std::vector<int>> optimizer_modality_idxs_;
+  std::vector<std::vector<std::shared_ptr<Body>>> optimizer_body_ptrs_;
+
+  // Convergence state, per optimizer
+  struct Convergence {
+    std::vector<Transform3fA> body2world_poses;  // before the update
+    float gradient_norm = -1.0f;
+    bool gradient_converged = false;
+    bool update_converged = false;
+    bool cycle_converged = false;
+  };
+  std::vector<Convergence> convergences_;
+
+  // Latency stages
+  struct LatencyStages {
+    int update_cameras = 0;
+    int start_modalities = 0;
+    int tracking_cycle = 0;
+    int correspondence_rendering = 0;
+    int results_rendering = 0;
+    int update_viewers = 0;
+    std::vector<int> correspondences;        // per modality
+    std::vector<int> gradient_and_hessian;   // per modality
+    std::vector<int> results;                // per modality
+    std::vector<int> optimization;           // per optimizer
+  } stages_;
+
+  // Data
+  std::vector<std::shared_ptr<PosePredictor>> pose_predictor_ptrs_;
+  bool measure_latencies_ = true;
+  LatencyRecorder latency_recorder_;
+  int n_threads_ = 1;
+  std::unique_ptr<ThreadPool> thread_pool_;
+  std::vector<char> task_results_;
+  float rerender_threshold_ = 0.0f;
+  std::map<const Renderer *, std::vector<Transform3fA>>
+      rendered_body2camera_poses_;
+  std::vector<Transform3fA> body2camera_poses_;
+  int n_renderings_ = 0;
+  int n_skipped_renderings_ = 0;
+  float convergence_rotation_ = 0.0f;
+  float convergence_translation_ = 0.0f;
+  float convergence_gradient_ = 0.0f;
+  bool image_rois_ = false;
+  std::vector<int> used_corr_iterations_;
+  std::vector<int> used_update_iterations_;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_extended_tracker_H_
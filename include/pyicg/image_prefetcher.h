@@ -0,0 +1,75 @@
+
+#ifndef ICG_INCLUDE_ICG_image_prefetcher_H_
+#define ICG_INCLUDE_ICG_image_prefetcher_H_
+
+#include <filesystem/filesystem.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace icg {
+
+/**
+ * \brief Decodes a list of image files on background threads, at most
+ * `capacity` images ahead of the one read with `Next()`.
+ *
+ * Images are decoded in parallel but returned in the order of the list, so
+ * memory stays constant whatever the length of the sequence.
+ *
+ * @param imread_flags flags passed to `cv::imread()`.
+ * @param n_threads number of decoding threads.
+ * @param capacity maximum number of decoded images waiting to be read.
+ */
+class ImagePrefetcher {
+ public:
+  // Constructor and destructor
+  ImagePrefetcher(int imread_flags, int n_threads = 2, int capacity = 8);
+  ~ImagePrefetcher();
+
+  // Main methods
+  void Start(const std::vector<std::filesystem::path> &image_paths);
+  void Stop();
+  bool Next(cv::Mat *image);
+
+  // Sorted files of a directory whose names start with prefix
+  static std::vector<std::filesystem::path> ListImages(
+      const std::filesystem::path &directory, const std::string &prefix);
+
+  // Getters
+  int n_threads() const;
+  int capacity() const;
+  int n_images() const;
+
+ private:
+  struct Slot {
+    int index = -1;
+    cv::Mat image;
+  };
+
+  // Helper method
+  void RunDecoder();
+
+  // Data
+  int imread_flags_;
+  int n_threads_;
+  int capacity_;
+  std::vector<std::filesystem::path> image_paths_;
+  std::vector<Slot> slots_;
+  std::vector<std::thread> decoders_;
+  std::mutex mutex_;
+  std::condition_variable decoded_condition_;
+  std::condition_variable free_condition_;
+  int next_decode_index_ = 0;
+  int next_read_index_ = 0;
+  bool stop_ = false;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_image_prefetcher_H_
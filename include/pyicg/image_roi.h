@@ -0,0 +1,75 @@
+#ifndef ICG_INCLUDE_ICG_image_roi_H_
+#define ICG_INCLUDE_ICG_image_roi_H_
+
+#include <icg/body.h>
+#include <icg/common.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+namespace icg {
+
+/**
+ * \brief Produces camera images downscaled by a fixed `scale`, in which only
+ * a region of interest around bodies is copied from the sensor image.
+ *
+ * The region of interest is the union of the projected bounding spheres of
+ * all added bodies at their current poses, enlarged by `margin` pixels. Pixels
+ * outside of it are 0, so the margin has to cover what modalities read around
+ * the bodies, e.g. region modality correspondence lines (see
+ * \ref ExtendedTracker). Output images keep the size of the scaled intrinsics,
+ * so that renderers and modalities set up once stay valid, while resizing,
+ * copying, and conversions only touch the region. Without bodies, the whole
+ * image is processed. Output buffers are reused across frames unless still
+ * referenced.
+ *
+ * @param scale factor between output and sensor resolution, at most 1.
+ * @param margin pixels added around projected bodies in the output image.
+ */
+class ImageRoi {
+ public:
+  // Constructor
+  explicit ImageRoi(float scale = 1.0f, int margin = 20);
+
+  // Setters
+  void set_scale(float scale);
+  void set_margin(int margin);
+  bool AddBody(const std::shared_ptr<Body> &body_ptr);
+  bool DeleteBody(const std::string &name);
+  void ClearBodies();
+
+  // Main methods
+  Intrinsics ScaleIntrinsics(const Intrinsics &sensor_intrinsics) const;
+  bool Process(const cv::Mat &sensor_image, int output_type, double alpha,
+               int interpolation, const Intrinsics &intrinsics,
+               const Transform3fA &world2camera_pose, cv::Mat *image);
+
+  // Getters
+  float scale() const;
+  int margin() const;
+  const std::vector<std::shared_ptr<Body>> &body_ptrs() const;
+  bool active() const;
+  const cv::Rect &roi() const;
+
+ private:
+  // Helper methods
+  cv::Rect ComputeRoi(const Intrinsics &intrinsics,
+                      const Transform3fA &world2camera_pose) const;
+
+  // Data
+  float scale_;
+  int margin_;
+  std::vector<std::shared_ptr<Body>> body_ptrs_;
+  cv::Mat image_;
+  cv::Mat resized_image_;
+  cv::Rect roi_;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_image_roi_H_
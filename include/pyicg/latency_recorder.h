@@ -0,0 +1,66 @@
+
+#ifndef ICG_INCLUDE_ICG_latency_recorder_H_
+#define ICG_INCLUDE_ICG_latency_recorder_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace icg {
+
+/**
+ * \brief Keeps the last `capacity` durations (in milliseconds) of named
+ * stages in lock-free ring buffers.
+ *
+ * Stages are added before recording starts. Durations are then recorded by a
+ * single thread per stage without locks, while statistics can be computed
+ * from any other thread on a snapshot of the buffers. Durations of stage
+ * indices that were not added are ignored.
+ */
+class LatencyRecorder {
+ public:
+  struct Statistics {
+    std::string stage;
+    int count = 0;  // number of samples in the snapshot
+    float mean = 0.0f;
+    float p50 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+  };
+
+  // Constructor
+  explicit LatencyRecorder(int capacity = 1024);
+
+  // Configure stages, returns the index used to record
+  int AddStage(const std::string &stage);
+  void ClearStages();
+
+  // Main methods
+  void Record(int stage_idx, float duration);
+  void Reset();
+  std::vector<Statistics> ComputeStatistics() const;
+
+  // Getters
+  int capacity() const;
+  int n_stages() const;
+  const std::string &stage(int stage_idx) const;
+  std::vector<float> samples(int stage_idx) const;
+
+ private:
+  struct Stage {
+    std::string name;
+    std::unique_ptr<std::atomic<float>[]> durations;
+    std::atomic<uint64_t> n_recorded{0};
+  };
+
+  // Data
+  int capacity_;
+  std::vector<std::unique_ptr<Stage>> stages_;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_latency_recorder_H_
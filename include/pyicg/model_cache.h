@@ -0,0 +1,98 @@
+
+#ifndef ICG_INCLUDE_ICG_model_cache_H_
+#define ICG_INCLUDE_ICG_model_cache_H_
+
+#include <filesystem/filesystem.h>
+#include <icg/body.h>
+#include <icg/common.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pyicg/rendering_backend.h"
+#include "pyicg/shared_model.h"
+
+namespace icg {
+
+/**
+ * \brief Creates \ref SharedRegionModel and \ref SharedDepthModel objects whose
+ * `model_path` in `cache_directory` is a hash of the geometry file content,
+ * the body geometry parameters, and the model parameters.
+ *
+ * Changing the mesh or any parameter thus results in a new model file instead
+ * of silently reusing a stale one. `SetUpModels()` sets up all created models
+ * on several threads, models missing from the cache being generated in
+ * parallel, each generation using its own renderer. GLFW only creates
+ * windows on the main thread, so models are set up serially on the calling
+ * thread with the `kGlfw` \ref RenderingBackend.
+ *
+ * Missing models are generated into a temporary file of the cache directory
+ * that is renamed into place once complete, so that other processes sharing
+ * the cache never load a partially written model. Models with
+ * `use_random_seed` are not reproducible and bypass the cache: they are
+ * generated into a temporary file that is removed after set up.
+ */
+class ModelCache {
+ public:
+  // Constructor and setup method
+  ModelCache(const std::string &name,
+             const std::filesystem::path &cache_directory);
+  bool SetUp();
+
+  // Create models stored in the cache
+  std::shared_ptr<SharedRegionModel> CreateRegionModel(
+      const std::string &name, const std::shared_ptr<Body> &body_ptr,
+      float sphere_radius = 0.8f, int n_divides = 4, int n_points = 200,
+      float max_radius_depth_offset = 0.05f,
+      float stride_depth_offset = 0.002f, bool use_random_seed = false,
+      int image_size = 2000);
+  std::shared_ptr<SharedDepthModel> CreateDepthModel(
+      const std::string &name, const std::shared_ptr<Body> &body_ptr,
+      float sphere_radius = 0.8f, int n_divides = 4, int n_points = 200,
+      float max_radius_depth_offset = 0.05f,
+      float stride_depth_offset = 0.002f, bool use_random_seed = false,
+      int image_size = 2000);
+
+  // Load or generate all created models, n_threads = 0 uses all cores
+  bool SetUpModels(int n_threads = 0);
+
+  // Getters
+  const std::string &name() const;
+  const std::filesystem::path &cache_directory() const;
+  bool set_up() const;
+
+ private:
+  // Helper methods
+  bool ModelPath(const std::string &model_type, const Body &body,
+                 float sphere_radius, int n_divides, int n_points,
+                 float max_radius_depth_offset, float stride_depth_offset,
+                 bool use_random_seed, int image_size,
+                 std::filesystem::path *model_path) const;
+  std::filesystem::path UniqueTemporaryPath(
+      const std::filesystem::path &path);
+  bool SetUpModel(const std::shared_ptr<Model> &model_ptr, bool cached);
+  static void HashBytes(const char *data, size_t size, uint64_t *hash);
+  static bool HashFile(const std::filesystem::path &path, uint64_t *hash);
+
+  // Data
+  std::string name_;
+  std::filesystem::path cache_directory_;
+  std::vector<std::shared_ptr<Model>> model_ptrs_;
+  std::vector<bool> model_cached_;
+  std::vector<std::shared_ptr<Body>> body_ptrs_;
+  std::atomic<int> n_temporary_paths_{0};
+  bool set_up_ = false;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_model_cache_H_
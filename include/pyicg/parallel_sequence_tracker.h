@@ -0,0 +1,74 @@
+
+#ifndef ICG_INCLUDE_ICG_parallel_sequence_tracker_H_
+#define ICG_INCLUDE_ICG_parallel_sequence_tracker_H_
+
+#include <icg/body.h>
+#include <icg/common.h>
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pyicg/sequence_tracker.h"
+
+namespace icg {
+
+/**
+ * \brief Tracks independent recorded sequences in parallel, with one worker
+ * thread per added \ref SequenceTracker.
+ *
+ * Each \ref SequenceTracker owns its \ref Tracker, cameras, bodies and
+ * renderer geometry, while objects that are only read during tracking, such as
+ * \ref RegionModel and \ref DepthModel, can be shared by all of them.
+ * Sequences are handed out to free workers one after the other. Before each
+ * sequence, body poses of the worker are reset to the ones they had in
+ * `SetUp()`. Workers must not contain viewers that display images.
+ */
+class ParallelSequenceTracker {
+ public:
+  // Constructor and setup method
+  ParallelSequenceTracker(const std::string &name);
+  bool SetUp();
+
+  // Configure workers
+  bool AddSequenceTracker(
+      const std::shared_ptr<SequenceTracker> &sequence_tracker_ptr);
+  void ClearSequenceTrackers();
+
+  // Main method, body2world_poses are stored per sequence, body, and frame.
+  // Poses of sequences that failed are left empty.
+  bool TrackSequences(
+      const std::vector<std::vector<cv::Mat>> &color_sequences,
+      const std::vector<std::vector<cv::Mat>> &depth_sequences,
+      std::vector<std::vector<std::vector<Transform3fA>>> *body2world_poses);
+
+  // Getters
+  const std::string &name() const;
+  const std::vector<std::shared_ptr<SequenceTracker>> &sequence_tracker_ptrs()
+      const;
+  bool set_up() const;
+
+ private:
+  // Helper method
+  void RunWorker(int worker_idx,
+                 const std::vector<std::vector<cv::Mat>> &color_sequences,
+                 const std::vector<std::vector<cv::Mat>> &depth_sequences,
+                 std::vector<std::vector<std::vector<Transform3fA>>>
+                     *body2world_poses);
+
+  // Data
+  std::string name_;
+  std::vector<std::shared_ptr<SequenceTracker>> sequence_tracker_ptrs_;
+  std::vector<std::vector<Transform3fA>> initial_body2world_poses_;
+  std::atomic<int> next_sequence_{0};
+  std::atomic<bool> all_succeeded_{true};
+  bool set_up_ = false;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_parallel_sequence_tracker_H_
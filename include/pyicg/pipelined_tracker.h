@@ -0,0 +1,135 @@
+
+#ifndef ICG_INCLUDE_ICG_pipelined_tracker_H_
+#define ICG_INCLUDE_ICG_pipelined_tracker_H_
+
+#include <icg/body.h>
+#include <icg/common.h>
+#include <icg/viewer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pyicg/bounded_queue.h"
+#include "pyicg/dummy_camera.h"
+#include "pyicg/sequence_tracker.h"
+
+namespace icg {
+
+/**
+ * \brief Tracks submitted frames on a dedicated thread while new frames are
+ * ingested, and optionally renders viewers on a third thread.
+ *
+ * Frames submitted with `SubmitFrame()` go through a bounded queue to the
+ * tracking thread, which runs `SequenceTracker::TrackFrame()` and publishes
+ * the body poses as results, read with `PollResult()`. Viewers render from a
+ * snapshot of the frame and poses: they must use their own cameras, renderer
+ * geometry, and bodies (named as the tracked bodies), since tracked ones are
+ * modified concurrently. Only the latest snapshot is rendered.
+ *
+ * Images of processed frames are released in the thread that calls
+ * `SubmitFrame()`, `PollResult()`, or `Stop()`, so that buffers owned by
+ * another runtime (e.g. numpy arrays) are not freed by pipeline threads.
+ *
+ * @param sequence_tracker_ptr tracker, cameras, and bodies of the tracking
+ * stage. Viewers of its tracker are not updated.
+ * @param queue_capacity maximum number of frames waiting to be tracked.
+ * @param drop_oldest drops the oldest waiting frame when the queue is full
+ * instead of blocking `SubmitFrame()`. Dropped frames are counted in
+ * `n_dropped_frames`. Results that are not polled are kept up to a fixed
+ * capacity, older ones are then dropped and counted in `n_dropped_results`.
+ */
+class PipelinedTracker {
+ public:
+  struct Frame {
+    int index = 0;
+    cv::Mat color_image;
+    cv::Mat depth_image;
+  };
+
+  struct Result {
+    int frame_index = 0;
+    bool success = false;
+    std::vector<Transform3fA> body2world_poses;  // as sequence tracker bodies
+  };
+
+  // Constructor, destructor, and setup method
+  PipelinedTracker(const std::string &name,
+                   const std::shared_ptr<SequenceTracker> &sequence_tracker_ptr,
+                   int queue_capacity = 2, bool drop_oldest = true);
+  ~PipelinedTracker();
+  bool SetUp();
+
+  // Configure viewer stage
+  bool AddViewer(const std::shared_ptr<Viewer> &viewer_ptr);
+  bool AddViewerBody(const std::shared_ptr<Body> &body_ptr);
+  void set_viewer_color_camera_ptr(
+      const std::shared_ptr<DummyColorCamera> &color_camera_ptr);
+  void set_viewer_depth_camera_ptr(
+      const std::shared_ptr<DummyDepthCamera> &depth_camera_ptr);
+
+  // Main methods
+  bool Start();
+  void Stop();
+  bool SubmitFrame(const cv::Mat &color_image, const cv::Mat &depth_image);
+  bool PollResult(Result *result, const std::chrono::milliseconds &timeout);
+
+  // Getters
+  const std::string &name() const;
+  const std::shared_ptr<SequenceTracker> &sequence_tracker_ptr() const;
+  const std::vector<std::shared_ptr<Viewer>> &viewer_ptrs() const;
+  const std::shared_ptr<DummyColorCamera> &viewer_color_camera_ptr() const;
+  const std::shared_ptr<DummyDepthCamera> &viewer_depth_camera_ptr() const;
+  int queue_capacity() const;
+  bool drop_oldest() const;
+  int n_submitted_frames() const;
+  int n_dropped_frames() const;
+  int n_dropped_results() const;
+  bool running() const;
+  bool set_up() const;
+
+ private:
+  struct ViewerSnapshot {
+    Frame frame;
+    std::vector<Transform3fA> body2world_poses;
+  };
+
+  // Helper methods
+  void RunTracking();
+  void RunViewers();
+  void ReleaseFrame(Frame &&frame);
+  void CollectProcessedFrames();
+
+  // Data
+  std::string name_;
+  std::shared_ptr<SequenceTracker> sequence_tracker_ptr_;
+  std::vector<std::shared_ptr<Viewer>> viewer_ptrs_;
+  std::vector<std::shared_ptr<Body>> viewer_body_ptrs_;
+  std::vector<int> viewer_body_indices_;
+  std::shared_ptr<DummyColorCamera> viewer_color_camera_ptr_;
+  std::shared_ptr<DummyDepthCamera> viewer_depth_camera_ptr_;
+  bool set_up_ = false;
+
+  // Pipeline
+  BoundedQueue<Frame> frame_queue_;
+  BoundedQueue<Result> result_queue_;
+  BoundedQueue<ViewerSnapshot> viewer_queue_{1, true};
+  std::thread tracking_thread_;
+  std::thread viewer_thread_;
+  std::mutex processed_frames_mutex_;
+  std::vector<Frame> processed_frames_;
+  std::atomic<bool> running_{false};
+  std::atomic<int> n_submitted_frames_{0};
+  std::atomic<int> n_dropped_frames_{0};
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_pipelined_tracker_H_
@@ -0,0 +1,67 @@
+#ifndef ICG_INCLUDE_ICG_pose_predictor_H_
+#define ICG_INCLUDE_ICG_pose_predictor_H_
+
+#include <icg/body.h>
+#include <icg/common.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace icg {
+
+/**
+ * \brief Predicts the pose of a body at the start of each tracking cycle with
+ * a constant-velocity model in SE(3).
+ *
+ * The motion between the last two tracked poses, expressed in the body frame,
+ * is applied again to the last tracked pose before correspondences are
+ * computed. Rotation and translation of this motion are scaled by
+ * `velocity_factor`, 1 being a constant velocity and 0 disabling the
+ * prediction. The velocity is reset whenever the pose of the body was set
+ * from outside the tracking cycle, e.g. by a detector.
+ *
+ * @param body_ptr body whose `body2world_pose` is predicted.
+ * @param velocity_factor factor applied to the estimated velocity.
+ */
+class PosePredictor {
+ public:
+  // Constructor and setup method
+  PosePredictor(const std::string &name, const std::shared_ptr<Body> &body_ptr,
+                float velocity_factor = 1.0f);
+  bool SetUp();
+
+  // Setters
+  void set_name(const std::string &name);
+  void set_body_ptr(const std::shared_ptr<Body> &body_ptr);
+  void set_velocity_factor(float velocity_factor);
+
+  // Main methods
+  bool PredictPose();
+  bool UpdateVelocity();
+  void Reset();
+
+  // Getters
+  const std::string &name() const;
+  const std::shared_ptr<Body> &body_ptr() const;
+  float velocity_factor() const;
+  bool has_velocity() const;
+  const Transform3fA &velocity() const;
+  bool set_up() const;
+
+ private:
+  // Data
+  std::string name_;
+  std::shared_ptr<Body> body_ptr_;
+  float velocity_factor_;
+  Transform3fA tracked_body2world_pose_{Transform3fA::Identity()};
+  Transform3fA velocity_{Transform3fA::Identity()};  // previous2current pose
+  bool has_tracked_pose_ = false;
+  bool has_velocity_ = false;
+  bool set_up_ = false;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_pose_predictor_H_
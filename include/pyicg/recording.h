@@ -0,0 +1,143 @@
+
+#ifndef ICG_INCLUDE_ICG_recording_H_
+#define ICG_INCLUDE_ICG_recording_H_
+
+#include <filesystem/filesystem.h>
+#include <icg/camera.h>
+#include <icg/common.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+namespace icg {
+
+/**
+ * \brief Camera parameters stored in the header of a recording.
+ */
+struct RecordingInfo {
+  Intrinsics color_intrinsics{};
+  Intrinsics depth_intrinsics{};
+  Transform3fA color2depth_pose{Transform3fA::Identity()};
+  float depth_scale = 0.001f;
+  bool has_depth = false;
+};
+
+/**
+ * \brief Writes synchronized BGR8 color and optional U16 depth frames to a
+ * binary recording file, read back with \ref RecordingReader.
+ *
+ * The file holds a fixed header with the \ref RecordingInfo, raw frame
+ * payloads aligned to 64 bytes, and a frame index with timestamps that is
+ * written by `Close()`. Until then, the header marks the file as not closed,
+ * so that recordings of crashed writers are rejected by the reader. A frame is
+ * written once its color image and, if the recording has depth, its depth
+ * image were added, in any order. Dummy cameras add their images in
+ * `UpdateImage()` when a writer is set.
+ *
+ * @param path file of the recording, overwritten by `Open()`.
+ */
+class RecordingWriter {
+ public:
+  // Constructor and destructor
+  RecordingWriter(const std::filesystem::path &path);
+  ~RecordingWriter();
+
+  // Main methods
+  bool Open(const RecordingInfo &info);
+  bool AddColorImage(const cv::Mat &image);
+  bool AddDepthImage(const cv::Mat &image);
+  bool Close();
+
+  // Getters
+  const std::filesystem::path &path() const;
+  const RecordingInfo &info() const;
+  int n_frames() const;
+  bool is_open() const;
+
+ private:
+  struct IndexEntry {
+    int64_t timestamp_ns;
+    uint64_t color_offset;
+    uint64_t depth_offset;
+  };
+
+  // Helper methods
+  bool AddImage(const cv::Mat &image, int type, const Intrinsics &intrinsics,
+                cv::Mat *pending_image);
+  bool WritePendingFrame();
+  bool WritePayload(const cv::Mat &image, uint64_t *offset);
+  bool WriteHeader(bool closed);
+
+  // Data
+  std::filesystem::path path_;
+  RecordingInfo info_;
+  std::ofstream ofs_;
+  std::vector<IndexEntry> index_;
+  cv::Mat pending_color_image_;
+  cv::Mat pending_depth_image_;
+  int64_t pending_timestamp_ns_ = 0;
+  uint64_t end_offset_ = 0;
+  std::mutex mutex_;
+  bool is_open_ = false;
+};
+
+/**
+ * \brief Memory-maps a recording written by \ref RecordingWriter and serves
+ * its frames without copying or decoding.
+ *
+ * Images returned by `color_image()` and `depth_image()` point into the read
+ * only mapping: they must not be written to and are only valid until the
+ * reader is closed, reopened, or destroyed, unless `mapping_ptr()` is held,
+ * which keeps the mapping alive. Frames can be accessed in any order.
+ *
+ * @param path file of the recording.
+ */
+class RecordingReader {
+ public:
+  // Constructor and destructor
+  RecordingReader(const std::filesystem::path &path);
+  ~RecordingReader();
+  RecordingReader(const RecordingReader &) = delete;
+  RecordingReader &operator=(const RecordingReader &) = delete;
+
+  // Main methods
+  bool Open();
+  void Close();
+
+  // Getters
+  const std::filesystem::path &path() const;
+  const RecordingInfo &info() const;
+  int n_frames() const;
+  bool is_open() const;
+  const std::shared_ptr<const uint8_t> &mapping_ptr() const;
+  cv::Mat color_image(int frame) const;
+  cv::Mat depth_image(int frame) const;
+  int64_t timestamp_ns(int frame) const;
+
+ private:
+  struct IndexEntry {
+    int64_t timestamp_ns;
+    uint64_t color_offset;
+    uint64_t depth_offset;
+  };
+
+  // Data
+  std::filesystem::path path_;
+  RecordingInfo info_;
+  std::shared_ptr<const uint8_t> mapping_ptr_;  // unmaps the file when released
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  const IndexEntry *index_ = nullptr;
+  int n_frames_ = 0;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_recording_H_
@@ -0,0 +1,40 @@
+
+#ifndef ICG_INCLUDE_ICG_rendering_backend_H_
+#define ICG_INCLUDE_ICG_rendering_backend_H_
+
+#include <icg/renderer_geometry.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+namespace icg {
+
+/**
+ * \brief OpenGL context creation used by every \ref RendererGeometry.
+ *
+ * `kGlfw` is the default GLFW window context and requires a display server.
+ * `kEgl` (surfaceless EGL, e.g. GPU drivers without X) and `kOsMesa` (CPU
+ * rendering with llvmpipe, threads set with `LP_NUM_THREADS`) create contexts
+ * without any display through the GLFW null platform (GLFW 3.4).
+ */
+enum class RenderingBackend { kGlfw, kEgl, kOsMesa };
+
+// Has to be called before the first RendererGeometry is set up, changes are
+// refused afterwards. GLFW window hints are global, so the backend applies to
+// all renderer geometries, each of them keeping its own context. Headless
+// backends set up an internal renderer geometry that keeps GLFW initialized
+// for the rest of the process.
+bool SetRenderingBackend(RenderingBackend backend);
+RenderingBackend rendering_backend();
+
+// Backend from the environment variable PYICG_RENDERING_BACKEND ("glfw",
+// "egl", or "osmesa"), or else the one selected at build time
+RenderingBackend DefaultRenderingBackend();
+
+bool ParseRenderingBackend(const std::string &name, RenderingBackend *backend);
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_rendering_backend_H_
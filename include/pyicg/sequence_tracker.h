@@ -0,0 +1,86 @@
+
+#ifndef ICG_INCLUDE_ICG_sequence_tracker_H_
+#define ICG_INCLUDE_ICG_sequence_tracker_H_
+
+#include <icg/body.h>
+#include <icg/common.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "pyicg/dummy_camera.h"
+#include "pyicg/extended_tracker.h"
+
+namespace icg {
+
+/**
+ * \brief Runs the tracking cycle of an \ref ExtendedTracker on a recorded sequence of
+ * images, fed frame by frame through a \ref DummyColorCamera and an optional
+ * \ref DummyDepthCamera.
+ *
+ * For each frame, images are set, cameras are updated, the tracking cycle is
+ * executed and the pose of every tracked body is recorded. Bodies are the ones
+ * referenced by the modalities of the tracker optimizers.
+ *
+ * @param tracker_ptr tracker that has to be set up before `SetUp()`.
+ * @param color_camera_ptr camera that receives color images.
+ * @param depth_camera_ptr optional camera that receives depth images.
+ * @param start_modalities starts modalities on the first frame, from the
+ * current body poses.
+ * @param update_viewers updates viewers after each tracking cycle.
+ */
+class SequenceTracker {
+ public:
+  // Constructor and setup method
+  SequenceTracker(const std::string &name,
+                  const std::shared_ptr<ExtendedTracker> &tracker_ptr,
+                  const std::shared_ptr<DummyColorCamera> &color_camera_ptr,
+                  const std::shared_ptr<DummyDepthCamera> &depth_camera_ptr =
+                      nullptr);
+  bool SetUp();
+
+  // Setters
+  void set_start_modalities(bool start_modalities);
+  void set_update_viewers(bool update_viewers);
+
+  // Main method, body2world_poses are stored per body, then per frame
+  bool TrackSequence(const std::vector<cv::Mat> &color_images,
+                     const std::vector<cv::Mat> &depth_images,
+                     std::vector<std::vector<Transform3fA>> *body2world_poses);
+
+  // Single step of TrackSequence(), depth_image is ignored without depth camera.
+  // Modalities are started if first_frame is set, by default for iteration 0
+  bool TrackFrame(int iteration, const cv::Mat &color_image,
+                  const cv::Mat &depth_image);
+  bool TrackFrame(int iteration, const cv::Mat &color_image,
+                  const cv::Mat &depth_image, bool first_frame);
+
+  // Getters
+  const std::string &name() const;
+  const std::shared_ptr<ExtendedTracker> &tracker_ptr() const;
+  const std::shared_ptr<DummyColorCamera> &color_camera_ptr() const;
+  const std::shared_ptr<DummyDepthCamera> &depth_camera_ptr() const;
+  const std::vector<std::shared_ptr<Body>> &body_ptrs() const;
+  bool start_modalities() const;
+  bool update_viewers() const;
+  bool set_up() const;
+
+ private:
+  // Data
+  std::string name_;
+  std::shared_ptr<ExtendedTracker> tracker_ptr_;
+  std::shared_ptr<DummyColorCamera> color_camera_ptr_;
+  std::shared_ptr<DummyDepthCamera> depth_camera_ptr_;
+  std::vector<std::shared_ptr<Body>> body_ptrs_;
+  bool start_modalities_ = true;
+  bool update_viewers_ = false;
+  bool set_up_ = false;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_sequence_tracker_H_
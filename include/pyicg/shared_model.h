@@ -0,0 +1,83 @@
+
+#ifndef ICG_INCLUDE_ICG_shared_model_H_
+#define ICG_INCLUDE_ICG_shared_model_H_
+
+#include <filesystem/filesystem.h>
+#include <icg/body.h>
+#include <icg/depth_model.h>
+#include <icg/region_model.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace icg {
+
+/**
+ * \brief \ref RegionModel or \ref DepthModel that is shared by many trackers,
+ * modalities, and threads.
+ *
+ * `SetUp()` is thread-safe and only loads (or generates) the model once:
+ * later calls, e.g. from `Tracker::SetUp()` of every tracker that uses the
+ * model, return immediately. Changing a parameter through a setter triggers a
+ * new set up. Once set up, the sparse views are only read.
+ *
+ * `Get()` returns the model already created in this process for the same
+ * `model_path` and parameters, so that bodies with the same geometry and
+ * parallel trackers share one copy of the views.
+ *
+ * Sharing is limited to one process: the views are heap vectors of the ICG
+ * model, so every process still reads and parses the whole model file.
+ */
+template <class ModelType>
+class SharedModel : public ModelType {
+ public:
+  // Constructors and setup method
+  using ModelType::ModelType;
+  bool SetUp() override {
+    const std::lock_guard<std::mutex> lock{set_up_mutex_};
+    if (this->set_up()) return true;
+    return ModelType::SetUp();
+  }
+
+  // Model already used in the process for the same file and parameters
+  static std::shared_ptr<SharedModel> Get(
+      const std::string &name, const std::shared_ptr<Body> &body_ptr,
+      const std::filesystem::path &model_path, float sphere_radius = 0.8f,
+      int n_divides = 4, int n_points = 200,
+      float max_radius_depth_offset = 0.05f,
+      float stride_depth_offset = 0.002f, bool use_random_seed = false,
+      int image_size = 2000) {
+    std::stringstream key;
+    key << std::filesystem::absolute(model_path).string() << "|"
+        << sphere_radius << "|" << n_divides << "|" << n_points << "|"
+        << max_radius_depth_offset << "|" << stride_depth_offset << "|"
+        << use_random_seed << "|" << image_size;
+
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<SharedModel>> model_ptrs;
+    const std::lock_guard<std::mutex> lock{mutex};
+    auto &registered_model_ptr{model_ptrs[key.str()]};
+    auto model_ptr{registered_model_ptr.lock()};
+    if (!model_ptr) {
+      model_ptr = std::make_shared<SharedModel>(
+          name, body_ptr, model_path, sphere_radius, n_divides, n_points,
+          max_radius_depth_offset, stride_depth_offset, use_random_seed,
+          image_size);
+      registered_model_ptr = model_ptr;
+    }
+    return model_ptr;
+  }
+
+ private:
+  std::mutex set_up_mutex_;
+};
+
+using SharedRegionModel = SharedModel<RegionModel>;
+using SharedDepthModel = SharedModel<DepthModel>;
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_shared_model_H_
@@ -0,0 +1,87 @@
+
+#ifndef ICG_INCLUDE_ICG_shm_frame_ring_H_
+#define ICG_INCLUDE_ICG_shm_frame_ring_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+
+namespace icg {
+
+/**
+ * \brief Ring of image slots in POSIX shared memory, written by a producer
+ * process and read without copy by a single consumer process.
+ *
+ * The producer `Create()`s the ring and copies every frame into the next free
+ * slot with `Publish()`. The consumer `Open()`s it and `AcquireLatest()`
+ * returns an image pointing to the most recent complete slot, which the
+ * producer skips until the next `AcquireLatest()` or `Release()`. If no
+ * complete slot could be acquired, the slot held before stays claimed.
+ * `WaitForFrame()` waits for a frame index of at least `min_frame_index` and
+ * keeps the current slot and outputs if it times out. Slots are guarded by
+ * sequence counters that are odd while a slot is written, so no locks are
+ * shared between processes.
+ *
+ * @param shm_name name of the shared memory object, e.g. "/pyicg_color".
+ */
+class ShmFrameRing {
+ public:
+  // Constructor and destructor
+  ShmFrameRing(const std::string &shm_name);
+  ~ShmFrameRing();
+  ShmFrameRing(const ShmFrameRing &) = delete;
+  ShmFrameRing &operator=(const ShmFrameRing &) = delete;
+
+  // Producer methods, at least 2 slots, 3 so that Publish() never fails
+  // while the consumer acquires a slot
+  bool Create(int width, int height, int type, int n_slots = 4);
+  bool Publish(const cv::Mat &image, int64_t timestamp_ns = 0);
+
+  // Consumer methods
+  bool Open();
+  bool AcquireLatest(cv::Mat *image, uint64_t *frame_index = nullptr,
+                     int64_t *timestamp_ns = nullptr);
+  bool WaitForFrame(uint64_t min_frame_index,
+                    const std::chrono::milliseconds &timeout, cv::Mat *image,
+                    uint64_t *frame_index = nullptr,
+                    int64_t *timestamp_ns = nullptr);
+  void Release();
+
+  // Unmaps the ring, the producer also removes the shared memory object
+  void Close();
+
+  // Getters
+  const std::string &shm_name() const;
+  bool is_open() const;
+  bool is_producer() const;
+  int width() const;
+  int height() const;
+  int type() const;
+  int n_slots() const;
+  uint64_t n_published_frames() const;
+
+ private:
+  struct RingHeader;
+  struct SlotHeader;
+
+  // Helper methods
+  bool Map(int fd, size_t size);
+  bool IsClaimed(int slot_idx) const;
+  SlotHeader *slot(int slot_idx) const;
+  uint8_t *slot_data(int slot_idx) const;
+
+  // Data
+  std::string shm_name_;
+  uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  RingHeader *header_ = nullptr;
+  bool is_producer_ = false;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_shm_frame_ring_H_
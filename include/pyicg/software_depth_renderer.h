@@ -0,0 +1,86 @@
+#ifndef ICG_INCLUDE_ICG_software_depth_renderer_H_
+#define ICG_INCLUDE_ICG_software_depth_renderer_H_
+
+#include <icg/body.h>
+#include <icg/camera.h>
+#include <icg/common.h>
+#include <icg/renderer.h>
+#include <icg/renderer_geometry.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pyicg/thread_pool.h"
+
+namespace icg {
+
+/**
+ * \brief \ref FocusedDepthRenderer that rasterizes the focused depth image of
+ * referenced bodies on the CPU, with tiles distributed over several threads.
+ *
+ * It can replace \ref FocusedBasicDepthRenderer in `ModelOcclusions()` of
+ * modalities on hosts without GPU. Triangles are read once in `SetUp()` from
+ * the vertex buffers of the \ref RendererGeometry, which therefore has to be
+ * set up and contain all referenced bodies, and no OpenGL is used afterwards.
+ * `StartRendering()` rasterizes and `FetchDepthImage()` writes the result to
+ * `focused_depth_image` with the same encoding as the OpenGL depth buffer.
+ * Triangles that cross `z_min` are not rendered.
+ *
+ * @param n_threads rendering threads, 0 uses all cores.
+ */
+class SoftwareDepthRenderer : public FocusedDepthRenderer {
+ public:
+  // Constructor and setup method
+  SoftwareDepthRenderer(
+      const std::string &name,
+      const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
+      const std::shared_ptr<Camera> &camera_ptr, int image_size = 200,
+      float z_min = 0.02f, float z_max = 10.0f, int n_threads = 0);
+  bool SetUp() override;
+
+  // Main methods
+  bool StartRendering() override;
+  bool FetchDepthImage() override;
+
+  // Getters
+  int n_threads() const;
+  float corner_u() const;
+  float corner_v() const;
+  float scale() const;
+  bool IsBodyVisible(const std::string &name) const;
+
+ private:
+  struct ScreenTriangle {
+    Eigen::Vector2f p0, p1, p2;    // focused image coordinates
+    float inv_z0, inv_z1, inv_z2;  // interpolated linearly on screen
+    int body_idx;
+  };
+
+  // Helper methods
+  bool LoadVertices();
+  bool CalculateFocus();
+  void AssembleTriangles();
+  void RasterizeTile(int tile_idx);
+
+  // Data
+  std::unique_ptr<ThreadPool> thread_pool_;
+  std::vector<std::vector<Eigen::Vector3f>> vertices_;  // triangle lists
+  std::vector<ScreenTriangle> triangles_;
+  std::vector<std::vector<int>> tile_triangle_idxs_;
+  std::vector<Eigen::Vector3f> camera_vertices_;
+  int n_tiles_per_row_ = 0;
+  cv::Mat metric_depth_image_;
+  cv::Mat body_idx_image_;
+  std::vector<char> body_visible_;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_software_depth_renderer_H_
@@ -0,0 +1,59 @@
+
+#ifndef ICG_INCLUDE_ICG_thread_pool_H_
+#define ICG_INCLUDE_ICG_thread_pool_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace icg {
+
+/**
+ * \brief Persistent worker threads that execute the tasks of a parallel loop.
+ *
+ * `ParallelFor()` hands out task indices one at a time from a shared counter,
+ * so that idle threads pick up the remaining tasks of slower ones. The calling
+ * thread works on tasks as well and returns once all of them are done. Tasks
+ * must not call `ParallelFor()` of the same pool.
+ *
+ * @param n_threads total number of threads including the calling one. With 1,
+ * tasks are executed in order on the calling thread.
+ */
+class ThreadPool {
+ public:
+  // Constructor and destructor
+  explicit ThreadPool(int n_threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Main method
+  void ParallelFor(int n_tasks, const std::function<void(int)> &task);
+
+  // Getters
+  int n_threads() const;
+
+ private:
+  // Helper methods
+  void RunWorker();
+  void RunTasks();
+
+  // Data
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_condition_;
+  std::condition_variable done_condition_;
+  const std::function<void(int)> *task_ = nullptr;
+  int n_tasks_ = 0;
+  std::atomic<int> next_task_{0};
+  int n_busy_workers_ = 0;
+  size_t generation_ = 0;
+  bool stop_ = false;
+};
+
+}  // namespace icg
+
+#endif  // ICG_INCLUDE_ICG_thread_pool_H_
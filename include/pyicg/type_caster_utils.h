@@ -102,15 +102,75 @@ namespace pybind11
 {
     namespace detail
     {
+        /**
+         * cv::MatAllocator whose UMatData keeps a reference to the numpy array owning the buffer.
+         * A cv::Mat loaded from numpy then shares the array memory (no copy) and keeps the array
+         * alive as long as the Mat or any of its copies exists, e.g. when stored as a camera image.
+         * Only buffer wrapping is specific: Mats reallocated by OpenCV use the standard allocator.
+         */
+        class NumpyMatAllocator : public cv::MatAllocator
+        {
+        public:
+            //! Wrap the buffer of a numpy array, GIL has to be held by the caller
+            cv::UMatData *allocate(PyObject *o, void *data, size_t size) const
+            {
+                cv::UMatData *u = new cv::UMatData(this);
+                u->data = u->origdata = static_cast<uchar *>(data);
+                u->size = size;
+                u->userdata = o;
+                Py_INCREF(o);
+                return u;
+            }
+
+            cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                                   cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const override
+            {
+                return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+            }
+
+            bool allocate(cv::UMatData *u, cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const override
+            {
+                return cv::Mat::getStdAllocator()->allocate(u, flags, usage_flags);
+            }
+
+            void deallocate(cv::UMatData *u) const override
+            {
+                if (!u)
+                    return;
+                CV_Assert(u->urefcount >= 0 && u->refcount >= 0);
+                if (u->refcount == 0)
+                {
+                    // The last Mat may be released from a C++ thread that does not hold the GIL
+                    if (Py_IsInitialized())
+                    {
+                        gil_scoped_acquire gil;
+                        Py_XDECREF(static_cast<PyObject *>(u->userdata));
+                    }
+                    delete u;
+                }
+            }
+
+            static const NumpyMatAllocator &instance()
+            {
+                // Never destroyed: Mats held by static objects may outlive this header's statics
+                static const NumpyMatAllocator *allocator = new NumpyMatAllocator;
+                return *allocator;
+            }
+        };
+
         template <>
         struct type_caster<cv::Mat>
         {
         public:
             PYBIND11_TYPE_CASTER(cv::Mat, _("numpy.ndarray"));
 
-            //! 1. cast numpy.ndarray to cv::Mat
+            //! 1. cast numpy.ndarray to cv::Mat, sharing (and pinning) the numpy buffer
             bool load(handle src, bool)
             {
+                if (!py::isinstance<py::array>(src))
+                {
+                    return false;
+                }
                 py::array b = py::reinterpret_borrow<array>(src);
                 py::buffer_info info = b.request();
 
@@ -136,6 +196,13 @@ namespace pybind11
                     throw std::logic_error(msg);
                     return false;
                 }
+                if (nc > CV_CN_MAX)
+                {
+                    char msg[64];
+                    std::sprintf(msg, "Unsupported number of channels %d", nc);
+                    throw std::logic_error(msg);
+                    return false;
+                }
 
                 int dtype;
                 if (info.format == py::format_descriptor<u_int8_t>::format())
@@ -160,11 +227,27 @@ namespace pybind11
                     return false;
                 }
 
-                value = cv::Mat(nh, nw, dtype, info.ptr);
+                // cv::Mat only supports an arbitrary row step: pixels and channels have to be packed.
+                // Other layouts (column slices, negative strides, ...) are copied into a C-style array.
+                size_t step;
+                if (!MatStep(info, nh, nw, nc, &step))
+                {
+                    b = py::array::ensure(b, py::array::c_style);
+                    if (!b)
+                    {
+                        return false;
+                    }
+                    info = b.request();
+                    MatStep(info, nh, nw, nc, &step);
+                }
+
+                value = cv::Mat(nh, nw, dtype, info.ptr, step);
+                value.u = NumpyMatAllocator::instance().allocate(b.ptr(), info.ptr, step * nh);
+                value.addref();
                 return true;
             }
 
-            //! 2. cast cv::Mat to numpy.ndarray
+            //! 2. cast cv::Mat to numpy.ndarray, a view on the Mat buffer kept alive by a capsule base
             static handle cast(const cv::Mat &mat,
                                py::return_value_policy /* policy */,
                                py::handle /* parent */)
@@ -204,19 +287,51 @@ namespace pybind11
                     throw std::logic_error("Unsupport type, only support u_int8_t, u_int16_t, int32, float");
                 }
 
-                std::vector<size_t> bufferdim;
-                std::vector<size_t> strides;
+                // The capsule holds a reference on the Mat data (O(1) whatever the image size). The array
+                // aliases the buffer: writers reusing it in place (ImageRoi output, converted depth,
+                // renderer images) change the array too.
+                // Mats without refcount wrap memory they do not own (recording and shared memory
+                // mappings), numpy gets its own copy instead.
+                cv::Mat *owner = new cv::Mat(mat.u || mat.empty() ? mat : mat.clone());
+                py::capsule base(owner, [](void *p)
+                                 { delete static_cast<cv::Mat *>(p); });
+
+                // Row step of the Mat is kept, e.g. for ROIs of a larger image
+                std::vector<py::ssize_t> bufferdim;
+                std::vector<py::ssize_t> strides;
                 if (dim == 2)
                 {
-                    bufferdim = {(size_t)nh, (size_t)nw};
-                    strides = {elemsize * (size_t)nw, elemsize};
+                    bufferdim = {nh, nw};
+                    strides = {(py::ssize_t)owner->step[0], (py::ssize_t)elemsize};
                 }
                 else if (dim == 3)
                 {
-                    bufferdim = {(size_t)nh, (size_t)nw, (size_t)nc};
-                    strides = {(size_t)elemsize * nw * nc, (size_t)elemsize * nc, (size_t)elemsize};
+                    bufferdim = {nh, nw, nc};
+                    strides = {(py::ssize_t)owner->step[0], (py::ssize_t)(elemsize * nc), (py::ssize_t)elemsize};
                 }
-                return py::array(py::buffer_info(mat.data, elemsize, format, dim, bufferdim, strides)).release();
+                return py::array(py::dtype(format), bufferdim, strides, owner->data, base).release();
+            }
+
+        private:
+            //! Row step of a cv::Mat sharing the buffer, false if the numpy layout cannot be expressed
+            static bool MatStep(const py::buffer_info &info, int nh, int nw, int nc, size_t *step)
+            {
+                const py::ssize_t elemsize = info.itemsize;
+                const py::ssize_t pixelsize = elemsize * nc;
+                // Strides of dimensions of size 1 are irrelevant (and arbitrary in numpy)
+                if (info.ndim == 3 && nc > 1 && info.strides[2] != elemsize)
+                    return false;
+                if (nw > 1 && info.strides[1] != pixelsize)
+                    return false;
+                if (nh == 1)
+                {
+                    *step = size_t(pixelsize * nw);
+                    return true;
+                }
+                if (info.strides[0] < pixelsize * nw || info.strides[0] % elemsize != 0)
+                    return false;
+                *step = size_t(info.strides[0]);
+                return true;
             }
         };
     }
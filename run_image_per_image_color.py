@@ -123,8 +123,6 @@ region_modality = pyicg.RegionModality(args.body_name + '_region_modality', body
 
 
 if args.model_occlusions:
-    raise NotImplementedError('region_modality.ModelOcclusions binding does not work properly yet')
-
     """
     FocusedRenderer: interface with OpenGL, render only part of the image where tracked objects are present 
                     -> projection matrix is recomputed each time a new render is done (contrary to FullRender)
@@ -133,7 +131,7 @@ if args.model_occlusions:
     color_depth_renderer = pyicg.FocusedBasicDepthRenderer('color_depth_renderer', renderer_geometry, color_camera)
     color_depth_renderer.AddReferencedBody(body)
 
-    region_modality.ModelOcclusions(color_depth_renderer)  # NOT WORKING
+    region_modality.ModelOcclusions(color_depth_renderer)
 
 
 optimizer = pyicg.Optimizer('optimizer')
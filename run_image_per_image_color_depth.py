@@ -49,6 +49,7 @@ def parse_script_input():
     parser.add_argument('--nb_img_load',   dest='nb_img_load',   type=int, default=-1)
     parser.add_argument('--use_depth',     dest='use_depth',     action='store_true', default=False)
     parser.add_argument('--model_occlusions', dest='model_occlusions', action='store_true', default=False)
+    parser.add_argument('--n_threads',     dest='n_threads',     type=int, default=None, help='Threads of the tracking cycle, default: 2 with --use_depth (region and depth modalities concurrently), else 1')
     parser.add_argument('-s', '--stop',    dest='stop',          action='store_true', default=False)
 
     return parser.parse_args()
@@ -66,21 +67,24 @@ camera_file = args.camera_file
 use_depth = args.use_depth
 model_occlusions = args.model_occlusions
 nb_img_load = args.nb_img_load
+n_threads = args.n_threads if args.n_threads is not None else (2 if use_depth else 1)
 stop = args.stop
 
 
 tracker = pyicg.Tracker('tracker', synchronize_cameras=False)
+tracker.n_threads = n_threads
 
 renderer_geometry = pyicg.RendererGeometry('renderer geometry')
 
 with open(config_dir / camera_file, 'r') as f:
     cam = yaml.load(f.read(), Loader=yaml.UnsafeLoader)
 
-color_camera = pyicg.DummyColorCamera('cam_color')
+# Images are read from imgs_dir and decoded in the background by the cameras, UpdateImage advancing to the next one
+color_camera = pyicg.ImageSequenceColorCamera('cam_color', imgs_dir.as_posix(), 'bgr')
 color_camera.color2depth_pose = tq_to_SE3(cam['trans_d_c'], cam['quat_d_c_xyzw'])
 color_camera.intrinsics = pyicg.Intrinsics(**cam['intrinsics_color'])
 
-depth_camera = pyicg.DummyDepthCamera('cam_depth')
+depth_camera = pyicg.ImageSequenceDepthCamera('cam_depth', imgs_dir.as_posix(), 'depth')
 depth_camera.depth2color_pose = inv_SE3(color_camera.color2depth_pose)
 depth_camera.intrinsics = pyicg.Intrinsics(**cam['intrinsics_depth'])
 
@@ -117,8 +121,6 @@ depth_modality = pyicg.DepthModality(body_name + '_depth_modality', body, depth_
 
 
 if model_occlusions:
-    raise NotImplementedError('region_modality.ModelOcclusions binding does not work properly yet')
-
     """
     FocusedRenderer: interface with OpenGL, render only part of the image where tracked objects are present 
                     -> projection matrix is recomputed each time a new render is done (contrary to FullRender)
@@ -140,24 +142,15 @@ if use_depth:
     optimizer.AddModality(depth_modality)
 tracker.AddOptimizer(optimizer)
 
+# LIMIT nb images
+if nb_img_load > 0:
+    color_camera.image_paths = sorted(glob.glob((imgs_dir / 'bgr*').as_posix()))[:nb_img_load]
+    depth_camera.image_paths = sorted(glob.glob((imgs_dir / 'depth*').as_posix()))[:nb_img_load]
+
 # Do all the necessary heavy preprocessing
 ok = tracker.SetUp()
 print('tracker.SetUp ok: ', ok)
-
-# read images from disk
-rgb_names = sorted(glob.glob((imgs_dir / 'bgr*').as_posix()))
-depth_names = sorted(glob.glob((imgs_dir / 'depth*').as_posix()))
-
-# LIMIT nb images
-rgb_names = rgb_names[:nb_img_load]
-depth_names = depth_names[:nb_img_load]
-print(f'{len(rgb_names)} images to load')
-
-# load images from disk
-color_read_flags = cv2.IMREAD_COLOR + cv2.IMREAD_ANYDEPTH
-img_bgr_lst = [cv2.imread(name, color_read_flags) for name in rgb_names]  # loads a dtype=uint8 array
-depth_read_flags = cv2.IMREAD_GRAYSCALE + cv2.IMREAD_ANYDEPTH
-img_depth_lst = [cv2.imread(name, depth_read_flags) for name in depth_names]  # loads a dtype=uint8 array
+print(f'{len(color_camera.image_paths)} images to track')
 
 print(tracker.n_corr_iterations)
 print(tracker.n_update_iterations)
@@ -165,14 +158,12 @@ print(tracker.n_update_iterations)
 tracker.n_update_iterations = 5
 
 # Simulate one iteration of Tracker::RunTrackerProcess for loop
-for iter, (img_bgr, img_depth) in enumerate(zip(img_bgr_lst, img_depth_lst)):
+iter = 0
+while True:
     print('Iter: ', iter)
-    # 1) Update camera image -> replaces a call to the camera UpdateImage method (which does nothing for Dummy(Color|Depth)Camera) 
-    color_camera.image = img_bgr
-    depth_camera.image = img_depth
-    ok = tracker.UpdateCameras(True)  # poststep verifying the images have been properly setup
-    if not ok:
-        raise ValueError('Something is wrong with the provided images')
+    # 1) Update camera images -> the cameras advance to the next prefetched images, False at the end of the sequence
+    if not tracker.UpdateCameras(True):
+        break
 
     if iter == 0:
         # 2) Use detector or external init to update initial object pose
@@ -195,4 +186,10 @@ for iter, (img_bgr, img_depth) in enumerate(zip(img_bgr_lst, img_depth_lst)):
 
     if stop:
         cv2.waitKey(0)
+    iter += 1
+
 
+# Per-stage latencies measured by the tracker (ms)
+for stage, stats in tracker.stats().items():
+    if stats['count'] > 0:
+        print(f"{stage}: p50 {stats['p50']:.2f}, p99 {stats['p99']:.2f}, max {stats['max']:.2f}")
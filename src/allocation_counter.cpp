@@ -0,0 +1,114 @@
+#include "pyicg/allocation_counter.h"
+
+#ifdef PYICG_COUNT_ALLOCATIONS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<int64_t> n_allocations{0};
+
+void *Allocate(std::size_t size) {
+  n_allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void *AllocateAligned(std::size_t size, std::align_val_t alignment) {
+  n_allocations.fetch_add(1, std::memory_order_relaxed);
+  void *ptr = nullptr;
+  std::size_t align = std::max(static_cast<std::size_t>(alignment),
+                               sizeof(void *));
+  if (posix_memalign(&ptr, align, size == 0 ? 1 : size) != 0) return nullptr;
+  return ptr;
+}
+
+}  // namespace
+
+// Replacements of the global allocation functions, counting every call
+void *operator new(std::size_t size) {
+  if (void *ptr = Allocate(size)) return ptr;
+  throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size) {
+  if (void *ptr = Allocate(size)) return ptr;
+  throw std::bad_alloc{};
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return Allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return Allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  if (void *ptr = AllocateAligned(size, alignment)) return ptr;
+  throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  if (void *ptr = AllocateAligned(size, alignment)) return ptr;
+  throw std::bad_alloc{};
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return AllocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return AllocateAligned(size, alignment);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+
+namespace icg {
+
+int64_t AllocationCount() {
+  return n_allocations.load(std::memory_order_relaxed);
+}
+
+}  // namespace icg
+
+#else
+
+namespace icg {
+
+int64_t AllocationCount() { return -1; }
+
+}  // namespace icg
+
+#endif
@@ -58,7 +58,8 @@ void DummyColorCamera::set_image(const cv::Mat& img){
 
 void DummyColorCamera::set_intrinsics(const Intrinsics& _intrinsics)
 {
-  intrinsics_ = _intrinsics;
+  sensor_intrinsics_ = _intrinsics;
+  intrinsics_ = image_roi_.ScaleIntrinsics(_intrinsics);
 }
 
 void DummyColorCamera::set_color2depth_pose(const Transform3fA& color2depth_pose) {
@@ -73,6 +74,31 @@ void DummyColorCamera::set_depth2color_pose(const Transform3fA& depth2color_pose
   color2depth_pose_ = depth2color_pose.inverse();
 }
 
+void DummyColorCamera::set_recording_writer_ptr(
+    const std::shared_ptr<RecordingWriter> &recording_writer_ptr) {
+  recording_writer_ptr_ = recording_writer_ptr;
+}
+
+void DummyColorCamera::set_image_scale(float image_scale) {
+  image_roi_.set_scale(image_scale);
+  intrinsics_ = image_roi_.ScaleIntrinsics(sensor_intrinsics_);
+  set_up_ = false;
+}
+
+void DummyColorCamera::set_roi_margin(int roi_margin) {
+  image_roi_.set_margin(roi_margin);
+}
+
+bool DummyColorCamera::AddRoiBody(const std::shared_ptr<Body> &body_ptr) {
+  return image_roi_.AddBody(body_ptr);
+}
+
+bool DummyColorCamera::DeleteRoiBody(const std::string &name) {
+  return image_roi_.DeleteBody(name);
+}
+
+void DummyColorCamera::ClearRoiBodies() { image_roi_.ClearBodies(); }
+
 bool DummyColorCamera::UpdateImage(bool synchronized) {
   if (!set_up_) {
     std::cerr << "Set up dummy color camera " << name_ << " first"
@@ -83,9 +109,12 @@ bool DummyColorCamera::UpdateImage(bool synchronized) {
     std::cerr << "DummyColorCamera " << name_ << " image was not set" << std::endl;
     return false;
   }
+  if (image_roi_.active() && !ProcessRoi()) return false;
 
   // do nothing here, the image has to be manually set from the application code
 
+  // recording errors are reported by the writer and do not stop tracking
+  if (recording_writer_ptr_) recording_writer_ptr_->AddColorImage(image_);
   SaveImageIfDesired();
   return true;
 }
@@ -106,6 +135,16 @@ const Transform3fA& DummyColorCamera::get_depth2color_pose() const {
   return depth2color_pose_;
 }
 
+const std::shared_ptr<RecordingWriter> &DummyColorCamera::recording_writer_ptr() const {
+  return recording_writer_ptr_;
+}
+
+const Intrinsics &DummyColorCamera::sensor_intrinsics() const {
+  return sensor_intrinsics_;
+}
+
+const ImageRoi &DummyColorCamera::image_roi() const { return image_roi_; }
+
 bool DummyColorCamera::LoadMetaData() {
   // Open file storage from yaml
   cv::FileStorage fs;
@@ -128,6 +167,24 @@ bool DummyColorCamera::LoadMetaData() {
   return true;
 }
 
+bool DummyColorCamera::ProcessRoi() {
+  // Images that were not produced by the last call are new sensor images,
+  // others are processed again with the current poses
+  if (image_.data != roi_image_data_) sensor_image_ = image_;
+  if (sensor_image_.type() != CV_8UC3) {
+    std::cerr << "DummyColorCamera " << name_ << " requires a BGR8 image" << std::endl;
+    return false;
+  }
+  image_ = cv::Mat{};
+  if (!image_roi_.Process(sensor_image_, CV_8UC3, 1.0, cv::INTER_AREA,
+                          intrinsics_, world2camera_pose_, &image_)) {
+    std::cerr << "DummyColorCamera " << name_ << " region of interest could not be processed" << std::endl;
+    return false;
+  }
+  roi_image_data_ = image_.data;
+  return true;
+}
+
 
 /**
  * DummyDepthCamera implementation
@@ -173,12 +230,24 @@ void DummyDepthCamera::set_image(const cv::Mat& img){
   if (img.channels() != 1){
     std::cerr << "DummyDepthCamera::set_image requires a 1-channel depth image, provided: " << img.channels() << std::endl;
   }
-  image_ = img;
+  if (img.depth() != CV_32F || image_roi_.active()) {
+    image_ = img;
+    return;
+  }
+
+  // Metres to depth_scale units, vectorized by OpenCV. The buffer is reused
+  // unless another object still references the previous frame
+  image_ = cv::Mat{};
+  if (converted_image_.u && converted_image_.u->refcount > 1)
+    converted_image_ = cv::Mat{};
+  img.convertTo(converted_image_, CV_16U, 1.0 / depth_scale_);
+  image_ = converted_image_;
 }
 
 void DummyDepthCamera::set_intrinsics(const Intrinsics& _intrinsics)
 {
-  intrinsics_ = _intrinsics;
+  sensor_intrinsics_ = _intrinsics;
+  intrinsics_ = image_roi_.ScaleIntrinsics(_intrinsics);
 }
 
 void DummyDepthCamera::set_color2depth_pose(const Transform3fA& color2depth_pose) {
@@ -193,6 +262,31 @@ void DummyDepthCamera::set_depth2color_pose(const Transform3fA& depth2color_pose
   color2depth_pose_ = depth2color_pose.inverse();
 }
 
+void DummyDepthCamera::set_recording_writer_ptr(
+    const std::shared_ptr<RecordingWriter> &recording_writer_ptr) {
+  recording_writer_ptr_ = recording_writer_ptr;
+}
+
+void DummyDepthCamera::set_image_scale(float image_scale) {
+  image_roi_.set_scale(image_scale);
+  intrinsics_ = image_roi_.ScaleIntrinsics(sensor_intrinsics_);
+  set_up_ = false;
+}
+
+void DummyDepthCamera::set_roi_margin(int roi_margin) {
+  image_roi_.set_margin(roi_margin);
+}
+
+bool DummyDepthCamera::AddRoiBody(const std::shared_ptr<Body> &body_ptr) {
+  return image_roi_.AddBody(body_ptr);
+}
+
+bool DummyDepthCamera::DeleteRoiBody(const std::string &name) {
+  return image_roi_.DeleteBody(name);
+}
+
+void DummyDepthCamera::ClearRoiBodies() { image_roi_.ClearBodies(); }
+
 void DummyDepthCamera::set_depth_scale(float depth_scale) {
   depth_scale_ = depth_scale;
 }
@@ -207,9 +301,16 @@ bool DummyDepthCamera::UpdateImage(bool synchronized) {
     std::cerr << "DummyDepthCamera " << name_ << " image was not set" << std::endl;
     return false;
   }
+  if (image_roi_.active() && !ProcessRoi()) return false;
+  if (image_.type() != CV_16UC1) {
+    std::cerr << "DummyDepthCamera " << name_ << " requires a uint16 or float32 image" << std::endl;
+    return false;
+  }
 
   // do nothing here, the image has to be manually set from the application code
 
+  // recording errors are reported by the writer and do not stop tracking
+  if (recording_writer_ptr_) recording_writer_ptr_->AddDepthImage(image_);
   SaveImageIfDesired();
   return true;
 }
@@ -230,6 +331,16 @@ const Transform3fA& DummyDepthCamera::get_depth2color_pose() const {
   return depth2color_pose_;
 }
 
+const std::shared_ptr<RecordingWriter> &DummyDepthCamera::recording_writer_ptr() const {
+  return recording_writer_ptr_;
+}
+
+const Intrinsics &DummyDepthCamera::sensor_intrinsics() const {
+  return sensor_intrinsics_;
+}
+
+const ImageRoi &DummyDepthCamera::image_roi() const { return image_roi_; }
+
 bool DummyDepthCamera::LoadMetaData() {
   // Open file storage from yaml
   cv::FileStorage fs;
@@ -252,4 +363,349 @@ bool DummyDepthCamera::LoadMetaData() {
   return true;
 }
 
+bool DummyDepthCamera::ProcessRoi() {
+  // Images that were not produced by the last call are new sensor images,
+  // others are processed again with the current poses
+  if (image_.data != roi_image_data_) sensor_image_ = image_;
+  if (sensor_image_.type() != CV_16UC1 && sensor_image_.type() != CV_32FC1) {
+    std::cerr << "DummyDepthCamera " << name_ << " requires a uint16 or float32 image" << std::endl;
+    return false;
+  }
+  double alpha = sensor_image_.depth() == CV_32F ? 1.0 / depth_scale_ : 1.0;
+  image_ = cv::Mat{};
+  if (!image_roi_.Process(sensor_image_, CV_16UC1, alpha, cv::INTER_NEAREST,
+                          intrinsics_, world2camera_pose_, &image_)) {
+    std::cerr << "DummyDepthCamera " << name_ << " region of interest could not be processed" << std::endl;
+    return false;
+  }
+  roi_image_data_ = image_.data;
+  return true;
+}
+
+/**
+ * ImageSequenceColorCamera implementation
+*/
+
+ImageSequenceColorCamera::ImageSequenceColorCamera(
+    const std::string &name, const std::filesystem::path &image_directory,
+    const std::string &image_prefix, bool use_depth_as_world_frame,
+    int n_decode_threads, int prefetch_capacity)
+    : DummyColorCamera{name, use_depth_as_world_frame},
+      image_directory_{image_directory},
+      image_prefix_{image_prefix},
+      prefetcher_{cv::IMREAD_COLOR, n_decode_threads, prefetch_capacity} {}
+
+bool ImageSequenceColorCamera::SetUp() {
+  if (!DummyColorCamera::SetUp()) return false;
+  set_up_ = false;
+  if (!image_paths_set_)
+    image_paths_ = ImagePrefetcher::ListImages(image_directory_, image_prefix_);
+  if (image_paths_.empty()) {
+    std::cerr << "No images for camera " << name_ << std::endl;
+    return false;
+  }
+  index_ = -1;
+  prefetcher_.Start(image_paths_);
+  set_up_ = true;
+  return true;
+}
+
+void ImageSequenceColorCamera::set_image_paths(
+    const std::vector<std::filesystem::path> &image_paths) {
+  image_paths_ = image_paths;
+  image_paths_set_ = true;
+  set_up_ = false;
+}
+
+bool ImageSequenceColorCamera::UpdateImage(bool synchronized) {
+  if (!set_up_) {
+    std::cerr << "Set up image sequence color camera " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  cv::Mat image;
+  if (!prefetcher_.Next(&image)) return false;
+  index_++;
+  set_image(image);
+  return DummyColorCamera::UpdateImage(synchronized);
+}
+
+const std::vector<std::filesystem::path>
+    &ImageSequenceColorCamera::image_paths() const {
+  return image_paths_;
+}
+
+int ImageSequenceColorCamera::index() const { return index_; }
+
+
+/**
+ * ImageSequenceDepthCamera implementation
+*/
+
+ImageSequenceDepthCamera::ImageSequenceDepthCamera(
+    const std::string &name, const std::filesystem::path &image_directory,
+    const std::string &image_prefix, bool use_color_as_world_frame,
+    float depth_scale, int n_decode_threads, int prefetch_capacity)
+    : DummyDepthCamera{name, use_color_as_world_frame, depth_scale},
+      image_directory_{image_directory},
+      image_prefix_{image_prefix},
+      prefetcher_{cv::IMREAD_ANYDEPTH, n_decode_threads, prefetch_capacity} {}
+
+bool ImageSequenceDepthCamera::SetUp() {
+  if (!DummyDepthCamera::SetUp()) return false;
+  set_up_ = false;
+  if (!image_paths_set_)
+    image_paths_ = ImagePrefetcher::ListImages(image_directory_, image_prefix_);
+  if (image_paths_.empty()) {
+    std::cerr << "No images for camera " << name_ << std::endl;
+    return false;
+  }
+  index_ = -1;
+  prefetcher_.Start(image_paths_);
+  set_up_ = true;
+  return true;
+}
+
+void ImageSequenceDepthCamera::set_image_paths(
+    const std::vector<std::filesystem::path> &image_paths) {
+  image_paths_ = image_paths;
+  image_paths_set_ = true;
+  set_up_ = false;
+}
+
+bool ImageSequenceDepthCamera::UpdateImage(bool synchronized) {
+  if (!set_up_) {
+    std::cerr << "Set up image sequence depth camera " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  cv::Mat image;
+  if (!prefetcher_.Next(&image)) return false;
+  index_++;
+  set_image(image);
+  return DummyDepthCamera::UpdateImage(synchronized);
+}
+
+const std::vector<std::filesystem::path>
+    &ImageSequenceDepthCamera::image_paths() const {
+  return image_paths_;
+}
+
+int ImageSequenceDepthCamera::index() const { return index_; }
+
+
+/**
+ * RecordingColorCamera implementation
+*/
+
+RecordingColorCamera::RecordingColorCamera(
+    const std::string &name,
+    const std::shared_ptr<RecordingReader> &recording_reader_ptr,
+    bool use_depth_as_world_frame)
+    : DummyColorCamera{name, use_depth_as_world_frame},
+      recording_reader_ptr_{recording_reader_ptr} {}
+
+bool RecordingColorCamera::SetUp() {
+  set_up_ = false;
+  if (!recording_reader_ptr_->is_open())
+    if (!recording_reader_ptr_->Open()) return false;
+  const RecordingInfo &info{recording_reader_ptr_->info()};
+  set_intrinsics(info.color_intrinsics);
+  set_color2depth_pose(info.color2depth_pose);
+  next_frame_ = 0;
+  index_ = -1;
+  return DummyColorCamera::SetUp();
+}
+
+void RecordingColorCamera::set_next_frame(int next_frame) {
+  next_frame_ = next_frame;
+}
+
+bool RecordingColorCamera::UpdateImage(bool synchronized) {
+  if (!set_up_) {
+    std::cerr << "Set up recording color camera " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  if (next_frame_ < 0 || next_frame_ >= recording_reader_ptr_->n_frames())
+    return false;
+  index_ = next_frame_++;
+  mapping_ptr_ = recording_reader_ptr_->mapping_ptr();
+  image_ = recording_reader_ptr_->color_image(index_);
+  return DummyColorCamera::UpdateImage(synchronized);
+}
+
+const std::shared_ptr<RecordingReader>
+    &RecordingColorCamera::recording_reader_ptr() const {
+  return recording_reader_ptr_;
+}
+
+int RecordingColorCamera::index() const { return index_; }
+
+
+/**
+ * RecordingDepthCamera implementation
+*/
+
+RecordingDepthCamera::RecordingDepthCamera(
+    const std::string &name,
+    const std::shared_ptr<RecordingReader> &recording_reader_ptr,
+    bool use_color_as_world_frame)
+    : DummyDepthCamera{name, use_color_as_world_frame, 0.001f},
+      recording_reader_ptr_{recording_reader_ptr} {}
+
+bool RecordingDepthCamera::SetUp() {
+  set_up_ = false;
+  if (!recording_reader_ptr_->is_open())
+    if (!recording_reader_ptr_->Open()) return false;
+  const RecordingInfo &info{recording_reader_ptr_->info()};
+  if (!info.has_depth) {
+    std::cerr << "Recording " << recording_reader_ptr_->path()
+              << " has no depth" << std::endl;
+    return false;
+  }
+  set_intrinsics(info.depth_intrinsics);
+  set_color2depth_pose(info.color2depth_pose);
+  set_depth_scale(info.depth_scale);
+  next_frame_ = 0;
+  index_ = -1;
+  return DummyDepthCamera::SetUp();
+}
+
+void RecordingDepthCamera::set_next_frame(int next_frame) {
+  next_frame_ = next_frame;
+}
+
+bool RecordingDepthCamera::UpdateImage(bool synchronized) {
+  if (!set_up_) {
+    std::cerr << "Set up recording depth camera " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  if (next_frame_ < 0 || next_frame_ >= recording_reader_ptr_->n_frames())
+    return false;
+  index_ = next_frame_++;
+  mapping_ptr_ = recording_reader_ptr_->mapping_ptr();
+  image_ = recording_reader_ptr_->depth_image(index_);
+  return DummyDepthCamera::UpdateImage(synchronized);
+}
+
+const std::shared_ptr<RecordingReader>
+    &RecordingDepthCamera::recording_reader_ptr() const {
+  return recording_reader_ptr_;
+}
+
+int RecordingDepthCamera::index() const { return index_; }
+
+
+/**
+ * ShmColorCamera implementation
+*/
+
+ShmColorCamera::ShmColorCamera(const std::string &name,
+                               const std::string &shm_name,
+                               bool use_depth_as_world_frame,
+                               const std::chrono::milliseconds &timeout)
+    : DummyColorCamera{name, use_depth_as_world_frame},
+      ring_{shm_name},
+      timeout_{timeout} {}
+
+bool ShmColorCamera::SetUp() {
+  set_up_ = false;
+  // The image points into the mapping that Open() replaces
+  image_ = cv::Mat{};
+  has_frame_ = false;
+  if (!ring_.Open()) return false;
+  if (ring_.type() != CV_8UC3 ||
+      ring_.width() != sensor_intrinsics().width ||
+      ring_.height() != sensor_intrinsics().height) {
+    std::cerr << "Shared memory " << ring_.shm_name()
+              << " does not match the intrinsics of camera " << name_
+              << std::endl;
+    return false;
+  }
+  return DummyColorCamera::SetUp();
+}
+
+bool ShmColorCamera::UpdateImage(bool synchronized) {
+  if (!set_up_) {
+    std::cerr << "Set up shared memory color camera " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  uint64_t min_frame_index = synchronized && has_frame_ ? frame_index_ + 1 : 0;
+  if (!ring_.WaitForFrame(min_frame_index, timeout_, &image_, &frame_index_,
+                          &timestamp_ns_)) {
+    std::cerr << "No frame from shared memory " << ring_.shm_name()
+              << std::endl;
+    return false;
+  }
+  has_frame_ = true;
+  return DummyColorCamera::UpdateImage(synchronized);
+}
+
+const std::string &ShmColorCamera::shm_name() const {
+  return ring_.shm_name();
+}
+
+uint64_t ShmColorCamera::frame_index() const { return frame_index_; }
+
+int64_t ShmColorCamera::timestamp_ns() const { return timestamp_ns_; }
+
+
+/**
+ * ShmDepthCamera implementation
+*/
+
+ShmDepthCamera::ShmDepthCamera(const std::string &name,
+                               const std::string &shm_name,
+                               bool use_color_as_world_frame,
+                               float depth_scale,
+                               const std::chrono::milliseconds &timeout)
+    : DummyDepthCamera{name, use_color_as_world_frame, depth_scale},
+      ring_{shm_name},
+      timeout_{timeout} {}
+
+bool ShmDepthCamera::SetUp() {
+  set_up_ = false;
+  // The image points into the mapping that Open() replaces
+  image_ = cv::Mat{};
+  has_frame_ = false;
+  if (!ring_.Open()) return false;
+  if (ring_.type() != CV_16UC1 ||
+      ring_.width() != sensor_intrinsics().width ||
+      ring_.height() != sensor_intrinsics().height) {
+    std::cerr << "Shared memory " << ring_.shm_name()
+              << " does not match the intrinsics of camera " << name_
+              << std::endl;
+    return false;
+  }
+  return DummyDepthCamera::SetUp();
+}
+
+bool ShmDepthCamera::UpdateImage(bool synchronized) {
+  if (!set_up_) {
+    std::cerr << "Set up shared memory depth camera " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  uint64_t min_frame_index = synchronized && has_frame_ ? frame_index_ + 1 : 0;
+  if (!ring_.WaitForFrame(min_frame_index, timeout_, &image_, &frame_index_,
+                          &timestamp_ns_)) {
+    std::cerr << "No frame from shared memory " << ring_.shm_name()
+              << std::endl;
+    return false;
+  }
+  has_frame_ = true;
+  return DummyDepthCamera::UpdateImage(synchronized);
+}
+
+const std::string &ShmDepthCamera::shm_name() const {
+  return ring_.shm_name();
+}
+
+uint64_t ShmDepthCamera::frame_index() const { return frame_index_; }
+
+int64_t ShmDepthCamera::timestamp_ns() const { return timestamp_ns_; }
+
 }  // namespace icg
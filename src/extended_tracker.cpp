@@ -0,0 +1,518 @@
+#include "pyicg/extended_tracker.h"
+
+namespace icg {
+
+ExtendedTracker::ExtendedTracker(
+    const std::string &name, int n_corr_iterations, int n_update_iterations,
+    bool synchronize_cameras, const std::chrono::milliseconds &cycle_duration,
+    int visualization_time, int viewer_time)
+    : Tracker{name,           n_corr_iterations,  n_update_iterations,
+              synchronize_cameras, cycle_duration, visualization_time,
+              viewer_time} {
+  AddLatencyStages();
+}
+
+ExtendedTracker::ExtendedTracker(const std::string &name,
+                                 const std::filesystem::path &metafile_path)
+    : Tracker{name, metafile_path} {
+  AddLatencyStages();
+}
+
+bool ExtendedTracker::SetUp(bool set_up_all_objects) {
+  if (!Tracker::SetUp(set_up_all_objects)) return false;
+  for (auto &pose_predictor_ptr : pose_predictor_ptrs_) {
+    if (set_up_all_objects) {
+      if (!pose_predictor_ptr->SetUp()) return false;
+    } else if (!pose_predictor_ptr->set_up()) {
+      std::cerr << "Pose predictor " << pose_predictor_ptr->name()
+                << " was not set up" << std::endl;
+      return false;
+    }
+  }
+  AssembleStepObjectPtrs();
+  AddLatencyStages();
+  if (image_rois_) AddRoiBodies();
+  rendered_body2camera_poses_.clear();
+  return true;
+}
+
+void ExtendedTracker::set_measure_latencies(bool measure_latencies) {
+  measure_latencies_ = measure_latencies;
+}
+
+void ExtendedTracker::set_latency_capacity(int latency_capacity) {
+  latency_recorder_ = LatencyRecorder{latency_capacity};
+  AddLatencyStages();
+}
+
+void ExtendedTracker::set_n_threads(int n_threads) {
+  n_threads_ = std::max(n_threads, 1);
+  thread_pool_ = n_threads_ > 1 ? std::make_unique<ThreadPool>(n_threads_)
+                                : nullptr;
+}
+
+void ExtendedTracker::set_rerender_threshold(float rerender_threshold) {
+  rerender_threshold_ = rerender_threshold;
+  rendered_body2camera_poses_.clear();
+}
+
+void ExtendedTracker::set_convergence_rotation(float convergence_rotation) {
+  convergence_rotation_ = convergence_rotation;
+}
+
+void ExtendedTracker::set_convergence_translation(
+    float convergence_translation) {
+  convergence_translation_ = convergence_translation;
+}
+
+void ExtendedTracker::set_convergence_gradient(float convergence_gradient) {
+  convergence_gradient_ = convergence_gradient;
+}
+
+void ExtendedTracker::set_image_rois(bool image_rois) {
+  image_rois_ = image_rois;
+}
+
+bool ExtendedTracker::AddPosePredictor(
+    const std::shared_ptr<PosePredictor> &pose_predictor_ptr) {
+  for (auto &ptr : pose_predictor_ptrs_) {
+    if (ptr->name() == pose_predictor_ptr->name()) {
+      std::cerr << "Pose predictor " << pose_predictor_ptr->name()
+                << " already exists" << std::endl;
+      return false;
+    }
+  }
+  pose_predictor_ptrs_.push_back(pose_predictor_ptr);
+  return true;
+}
+
+bool ExtendedTracker::DeletePosePredictor(const std::string &name) {
+  for (auto it = begin(pose_predictor_ptrs_); it != end(pose_predictor_ptrs_);
+       ++it) {
+    if ((*it)->name() == name) {
+      pose_predictor_ptrs_.erase(it);
+      return true;
+    }
+  }
+  std::cerr << "Pose predictor " << name << " not found" << std::endl;
+  return false;
+}
+
+void ExtendedTracker::ClearPosePredictors() { pose_predictor_ptrs_.clear(); }
+
+bool ExtendedTracker::UpdateCameras(bool update_all_cameras) {
+  return MeasureStage(stages_.update_cameras, [&] {
+    return Tracker::UpdateCameras(update_all_cameras);
+  });
+}
+
+bool ExtendedTracker::StartModalities(int iteration) {
+  return MeasureStage(stages_.start_modalities,
+                      [&] { return Tracker::StartModalities(iteration); });
+}
+
+bool ExtendedTracker::ExecuteTrackingCycle(int iteration) {
+  if (!set_up()) {
+    std::cerr << "Set up tracker " << name() << " first" << std::endl;
+    return false;
+  }
+  const auto &optimizer_ptrs{this->optimizer_ptrs()};
+  return MeasureStage(stages_.tracking_cycle, [&] {
+    StartConvergenceChecks();
+    for (auto &pose_predictor_ptr : pose_predictor_ptrs_) {
+      if (!pose_predictor_ptr->PredictPose()) return false;
+    }
+    for (int corr_iteration = 0; corr_iteration < n_corr_iterations();
+         ++corr_iteration) {
+      if (AllOptimizersConverged()) break;
+      StartCorrespondenceIteration();
+      int corr_save_idx = iteration * n_corr_iterations() + corr_iteration;
+
+      // Correspondences
+      if (!MeasureStage(stages_.correspondence_rendering, [&] {
+            return StartRenderers(cycle_correspondence_renderer_ptrs_) &&
+                   FetchDepthImages(cycle_correspondence_renderer_ptrs_);
+          }))
+        return false;
+      if (!ForEachModality([&](int i) {
+            if (!ModalityActive(i)) return true;
+            return MeasureStage(stages_.correspondences[i], [&] {
+              return cycle_modality_ptrs_[i]->CalculateCorrespondences(
+                  iteration, corr_iteration);
+            });
+          }))
+        return false;
+      if (!VisualizeCorrespondences(corr_save_idx)) return false;
+
+      // Pose updates
+      for (int update_iteration = 0; update_iteration < n_update_iterations();
+           ++update_iteration) {
+        if (AllOptimizersConverged()) break;
+        int update_save_idx =
+            corr_save_idx * n_update_iterations() + update_iteration;
+        if (!ForEachModality([&](int i) {
+              if (!ModalityActive(i)) return true;
+              return MeasureStage(stages_.gradient_and_hessian[i], [&] {
+                return cycle_modality_ptrs_[i]->CalculateGradientAndHessian(
+                    iteration, corr_iteration, update_iteration);
+              });
+            }))
+          return false;
+        if (!ForEachOptimizer([&](int o) {
+              if (!OptimizerActive(o)) return true;
+              StartUpdate(o);
+              if (!MeasureStage(stages_.optimization[o], [&] {
+                    return optimizer_ptrs[o]->CalculateOptimization(
+                        iteration, corr_iteration, update_iteration);
+                  }))
+                return false;
+              FinishUpdate(o, update_iteration == 0);
+              return true;
+            }))
+          return false;
+        if (!VisualizeOptimization(update_save_idx)) return false;
+      }
+    }
+
+    // Results
+    if (!MeasureStage(stages_.results_rendering, [&] {
+          return StartRenderers(cycle_results_renderer_ptrs_) &&
+                 FetchDepthImages(cycle_results_renderer_ptrs_);
+        }))
+      return false;
+    if (!ForEachModality([&](int i) {
+          return MeasureStage(stages_.results[i], [&] {
+            return cycle_modality_ptrs_[i]->CalculateResults(iteration);
+          });
+        }))
+      return false;
+    for (auto &pose_predictor_ptr : pose_predictor_ptrs_) {
+      if (!pose_predictor_ptr->UpdateVelocity()) return false;
+    }
+    return VisualizeResults(iteration);
+  });
+}
+
+bool ExtendedTracker::UpdateViewers(int iteration) {
+  return MeasureStage(stages_.update_viewers,
+                      [&] { return Tracker::UpdateViewers(iteration); });
+}
+
+std::vector<LatencyRecorder::Statistics>
+ExtendedTracker::ComputeLatencyStatistics() const {
+  return latency_recorder_.ComputeStatistics();
+}
+
+void ExtendedTracker::ResetLatencies() { latency_recorder_.Reset(); }
+
+bool ExtendedTracker::measure_latencies() const { return measure_latencies_; }
+
+int ExtendedTracker::latency_capacity() const {
+  return latency_recorder_.capacity();
+}
+
+int ExtendedTracker::n_threads() const { return n_threads_; }
+
+float ExtendedTracker::rerender_threshold() const {
+  return rerender_threshold_;
+}
+
+int ExtendedTracker::n_renderings() const { return n_renderings_; }
+
+int ExtendedTracker::n_skipped_renderings() const {
+  return n_skipped_renderings_;
+}
+
+float ExtendedTracker::convergence_rotation() const {
+  return convergence_rotation_;
+}
+
+float ExtendedTracker::convergence_translation() const {
+  return convergence_translation_;
+}
+
+float ExtendedTracker::convergence_gradient() const {
+  return convergence_gradient_;
+}
+
+bool ExtendedTracker::image_rois() const { return image_rois_; }
+
+const std::vector<int> &ExtendedTracker::used_corr_iterations() const {
+  return used_corr_iterations_;
+}
+
+const std::vector<int> &ExtendedTracker::used_update_iterations() const {
+  return used_update_iterations_;
+}
+
+const LatencyRecorder &ExtendedTracker::latency_recorder() const {
+  return latency_recorder_;
+}
+
+const std::vector<std::shared_ptr<PosePredictor>>
+    &ExtendedTracker::pose_predictor_ptrs() const {
+  return pose_predictor_ptrs_;
+}
+
+void ExtendedTracker::AssembleStepObjectPtrs() {
+  cycle_modality_ptrs_.clear();
+  cycle_correspondence_renderer_ptrs_.clear();
+  cycle_results_renderer_ptrs_.clear();
+  auto add_unique{[](const auto &ptr, auto *ptrs) {
+    if (ptr && std::find(begin(*ptrs), end(*ptrs), ptr) == end(*ptrs))
+      ptrs->push_back(ptr);
+  }};
+  optimizers_independent_ = true;
+  modality_optimizer_idxs_.clear();
+  optimizer_modality_idxs_.clear();
+  optimizer_body_ptrs_.clear();
+  std::vector<std::shared_ptr<Body>> optimized_body_ptrs;
+  for (auto &optimizer_ptr : optimizer_ptrs()) {
+    int optimizer_idx = int(optimizer_modality_idxs_.size());
+    std::vector<int> modality_idxs;
+    std::vector<std::shared_ptr<Body>> body_ptrs;
+    for (auto &modality_ptr : optimizer_ptr->modality_ptrs()) {
+      add_unique(modality_ptr, &cycle_modality_ptrs_);
+      int modality_idx = int(std::find(begin(cycle_modality_ptrs_),
+                                       end(cycle_modality_ptrs_),
+                                       modality_ptr) -
+                             begin(cycle_modality_ptrs_));
+      modality_optimizer_idxs_.resize(cycle_modality_ptrs_.size());
+      modality_optimizer_idxs_[modality_idx].push_back(optimizer_idx);
+      modality_idxs.push_back(modality_idx);
+      add_unique(modality_ptr->body_ptr(), &body_ptrs);
+      for (auto &renderer_ptr : modality_ptr->correspondence_renderer_ptrs())
+        add_unique(renderer_ptr, &cycle_correspondence_renderer_ptrs_);
+      for (auto &renderer_ptr : modality_ptr->results_renderer_ptrs())
+        add_unique(renderer_ptr, &cycle_results_renderer_ptrs_);
+    }
+    for (auto &body_ptr : body_ptrs) {
+      if (std::find(begin(optimized_body_ptrs), end(optimized_body_ptrs),
+                    body_ptr) != end(optimized_body_ptrs))
+        optimizers_independent_ = false;
+      optimized_body_ptrs.push_back(body_ptr);
+    }
+    optimizer_modality_idxs_.push_back(std::move(modality_idxs));
+    optimizer_body_ptrs_.push_back(std::move(body_ptrs));
+  }
+  convergences_.assign(optimizer_ptrs().size(), Convergence{});
+  used_corr_iterations_.assign(optimizer_ptrs().size(), 0);
+  used_update_iterations_.assign(optimizer_ptrs().size(), 0);
+  if (!optimizers_independent_ && n_threads_ > 1) {
+    std::cerr << "Optimizers of tracker " << name()
+              << " share bodies and are optimized serially" << std::endl;
+  }
+}
+
+void ExtendedTracker::AddRoiBodies() {
+  auto add_roi_body{[](const auto &camera_ptr,
+                       const std::shared_ptr<Body> &body_ptr, int margin) {
+    if (!camera_ptr) return;
+    const auto &roi_body_ptrs{camera_ptr->image_roi().body_ptrs()};
+    if (std::find(begin(roi_body_ptrs), end(roi_body_ptrs), body_ptr) ==
+        end(roi_body_ptrs))
+      camera_ptr->AddRoiBody(body_ptr);
+    if (camera_ptr->image_roi().margin() < margin)
+      camera_ptr->set_roi_margin(margin);
+  }};
+  for (auto &modality_ptr : cycle_modality_ptrs_) {
+    if (auto region_modality_ptr{
+            std::dynamic_pointer_cast<RegionModality>(modality_ptr)}) {
+      // Correspondence lines are centered on the contour, which lies within
+      // the projected bounding sphere. Half a line, rounded up, plus one pixel
+      // for the rounding of line centers, 58 pixels with the ICG defaults
+      const std::vector<int> &scales{region_modality_ptr->scales()};
+      int max_scale = scales.empty() ? 1 : *std::max_element(begin(scales),
+                                                             end(scales));
+      int line_length = region_modality_ptr->function_length() +
+                        region_modality_ptr->distribution_length() - 1;
+      int margin = (max_scale * line_length + 1) / 2 + 1;
+      add_roi_body(std::dynamic_pointer_cast<DummyColorCamera>(
+                       region_modality_ptr->color_camera_ptr()),
+                   modality_ptr->body_ptr(), margin);
+    } else if (auto depth_modality_ptr{
+                   std::dynamic_pointer_cast<DepthModality>(modality_ptr)}) {
+      add_roi_body(std::dynamic_pointer_cast<DummyDepthCamera>(
+                       depth_modality_ptr->depth_camera_ptr()),
+                   modality_ptr->body_ptr(), 0);
+    }
+  }
+}
+
+void ExtendedTracker::AddLatencyStages() {
+  latency_recorder_.ClearStages();
+  stages_ = LatencyStages{};
+  stages_.update_cameras = latency_recorder_.AddStage("update_cameras");
+  stages_.start_modalities = latency_recorder_.AddStage("start_modalities");
+  stages_.tracking_cycle = latency_recorder_.AddStage("tracking_cycle");
+  stages_.correspondence_rendering =
+      latency_recorder_.AddStage("correspondence_rendering");
+  stages_.results_rendering = latency_recorder_.AddStage("results_rendering");
+  stages_.update_viewers = latency_recorder_.AddStage("update_viewers");
+  for (auto &modality_ptr : cycle_modality_ptrs_) {
+    const std::string &name{modality_ptr->name()};
+    stages_.correspondences.push_back(
+        latency_recorder_.AddStage("correspondences/" + name));
+    stages_.gradient_and_hessian.push_back(
+        latency_recorder_.AddStage("gradient_and_hessian/" + name));
+    stages_.results.push_back(latency_recorder_.AddStage("results/" + name));
+  }
+  for (auto &optimizer_ptr : optimizer_ptrs()) {
+    stages_.optimization.push_back(
+        latency_recorder_.AddStage("optimization/" + optimizer_ptr->name()));
+  }
+}
+
+bool ExtendedTracker::StartRenderers(
+    const std::vector<std::shared_ptr<Renderer>> &renderer_ptrs) {
+  for (auto &renderer_ptr : renderer_ptrs) {
+    if (!RenderingRequired(renderer_ptr)) {
+      n_skipped_renderings_++;
+      continue;
+    }
+    if (!renderer_ptr->StartRendering()) return false;
+    n_renderings_++;
+  }
+  return true;
+}
+
+bool ExtendedTracker::RenderingRequired(
+    const std::shared_ptr<Renderer> &renderer_ptr) {
+  if (rerender_threshold_ <= 0.0f) return true;
+  auto focused_renderer_ptr{
+      std::dynamic_pointer_cast<FocusedDepthRenderer>(renderer_ptr)};
+  if (!focused_renderer_ptr) return true;
+
+  // Compare poses with the ones of the last rendering, which are updated
+  // whenever the renderer is started
+  const auto &body_ptrs{focused_renderer_ptr->referenced_body_ptrs()};
+  const Intrinsics &intrinsics{renderer_ptr->intrinsics()};
+  float focal_length = std::max(intrinsics.fu, intrinsics.fv);
+  body2camera_poses_.clear();
+  for (auto &body_ptr : body_ptrs)
+    body2camera_poses_.push_back(renderer_ptr->world2camera_pose() *
+                                 body_ptr->body2world_pose());
+  auto &rendered_poses{rendered_body2camera_poses_[renderer_ptr.get()]};
+  bool required = rendered_poses.size() != body_ptrs.size();
+  for (size_t i = 0; i < body_ptrs.size() && !required; ++i) {
+    const Transform3fA &pose{body2camera_poses_[i]};
+    const Transform3fA &rendered_pose{rendered_poses[i]};
+    float depth =
+        std::min(pose.translation().z(), rendered_pose.translation().z());
+    float translation =
+        (pose.translation() - rendered_pose.translation()).norm();
+    float rotation = Eigen::AngleAxisf{pose.rotation() *
+                                       rendered_pose.rotation().transpose()}
+                         .angle();
+    float radius = 0.5f * body_ptrs[i]->maximum_body_diameter();
+    required = depth <= 0.0f ||
+               focal_length * (translation + rotation * radius) / depth >
+                   rerender_threshold_;
+  }
+  if (required) rendered_poses.assign(begin(body2camera_poses_),
+                                      end(body2camera_poses_));
+  return required;
+}
+
+bool ExtendedTracker::FetchDepthImages(
+    const std::vector<std::shared_ptr<Renderer>> &renderer_ptrs) {
+  // Modalities fetch depth images themselves, but with several threads they
+  // would compete for the OpenGL context of the renderer
+  if (!thread_pool_) return true;
+  for (auto &renderer_ptr : renderer_ptrs) {
+    if (auto ptr{std::dynamic_pointer_cast<FocusedDepthRenderer>(renderer_ptr)})
+      if (!ptr->FetchDepthImage()) return false;
+    if (auto ptr{std::dynamic_pointer_cast<FullDepthRenderer>(renderer_ptr)})
+      if (!ptr->FetchDepthImage()) return false;
+  }
+  return true;
+}
+
+bool ExtendedTracker::adaptive_iterations() const {
+  return convergence_rotation_ > 0.0f || convergence_translation_ > 0.0f ||
+         convergence_gradient_ > 0.0f;
+}
+
+void ExtendedTracker::StartConvergenceChecks() {
+  // Fields are reset individually to keep the capacity of pose vectors
+  for (auto &convergence : convergences_) {
+    convergence.gradient_norm = -1.0f;
+    convergence.gradient_converged = false;
+    convergence.update_converged = false;
+    convergence.cycle_converged = false;
+  }
+  std::fill(begin(used_corr_iterations_), end(used_corr_iterations_), 0);
+  std::fill(begin(used_update_iterations_), end(used_update_iterations_), 0);
+}
+
+void ExtendedTracker::StartCorrespondenceIteration() {
+  for (int o = 0; o < int(convergences_.size()); ++o) {
+    convergences_[o].update_converged = false;
+    if (!convergences_[o].cycle_converged) used_corr_iterations_[o]++;
+  }
+}
+
+bool ExtendedTracker::OptimizerActive(int optimizer_idx) const {
+  const Convergence &convergence{convergences_[optimizer_idx]};
+  return !convergence.cycle_converged && !convergence.update_converged;
+}
+
+bool ExtendedTracker::ModalityActive(int modality_idx) const {
+  const auto &optimizer_idxs{modality_optimizer_idxs_[modality_idx]};
+  return std::any_of(begin(optimizer_idxs), end(optimizer_idxs),
+                     [&](int o) { return OptimizerActive(o); });
+}
+
+bool ExtendedTracker::AllOptimizersConverged() const {
+  for (int o = 0; o < int(convergences_.size()); ++o) {
+    if (OptimizerActive(o)) return false;
+  }
+  return true;
+}
+
+void ExtendedTracker::StartUpdate(int optimizer_idx) {
+  if (!adaptive_iterations()) return;
+  Convergence &convergence{convergences_[optimizer_idx]};
+  convergence.body2world_poses.clear();
+  for (auto &body_ptr : optimizer_body_ptrs_[optimizer_idx])
+    convergence.body2world_poses.push_back(body_ptr->body2world_pose());
+
+  // Gradients of all modalities are calculated before optimizations start
+  if (convergence_gradient_ <= 0.0f) return;
+  Eigen::Matrix<float, 6, 1> gradient{Eigen::Matrix<float, 6, 1>::Zero()};
+  for (int modality_idx : optimizer_modality_idxs_[optimizer_idx])
+    gradient += cycle_modality_ptrs_[modality_idx]->gradient();
+  float gradient_norm = gradient.norm();
+  convergence.gradient_converged =
+      convergence.gradient_norm > 0.0f &&
+      std::abs(gradient_norm - convergence.gradient_norm) <
+          convergence_gradient_ * convergence.gradient_norm;
+  convergence.gradient_norm = gradient_norm;
+}
+
+void ExtendedTracker::FinishUpdate(int optimizer_idx, bool first_update) {
+  used_update_iterations_[optimizer_idx]++;
+  if (!adaptive_iterations()) return;
+  Convergence &convergence{convergences_[optimizer_idx]};
+  bool pose_converged =
+      convergence_rotation_ > 0.0f || convergence_translation_ > 0.0f;
+  const auto &body_ptrs{optimizer_body_ptrs_[optimizer_idx]};
+  for (size_t i = 0; i < body_ptrs.size() && pose_converged; ++i) {
+    const Transform3fA &pose{body_ptrs[i]->body2world_pose()};
+    const Transform3fA &previous_pose{convergence.body2world_poses[i]};
+    float translation =
+        (pose.translation() - previous_pose.translation()).norm();
+    float rotation = Eigen::AngleAxisf{pose.rotation() *
+                                       previous_pose.rotation().transpose()}
+                         .angle();
+    pose_converged =
+        (convergence_rotation_ <= 0.0f || rotation < convergence_rotation_) &&
+        (convergence_translation_ <= 0.0f ||
+         translation < convergence_translation_);
+  }
+  if (!pose_converged && !convergence.gradient_converged) return;
+  convergence.update_converged = true;
+  if (first_update) convergence.cycle_converged = true;
+}
+
+}  // namespace icg
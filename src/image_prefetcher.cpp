@@ -0,0 +1,100 @@
+#include "pyicg/image_prefetcher.h"
+
+namespace icg {
+
+ImagePrefetcher::ImagePrefetcher(int imread_flags, int n_threads,
+                                 int capacity)
+    : imread_flags_{imread_flags},
+      n_threads_{std::max(n_threads, 1)},
+      capacity_{std::max(capacity, 1)} {}
+
+ImagePrefetcher::~ImagePrefetcher() { Stop(); }
+
+void ImagePrefetcher::Start(
+    const std::vector<std::filesystem::path> &image_paths) {
+  Stop();
+  image_paths_ = image_paths;
+  slots_.assign(capacity_, Slot{});
+  next_decode_index_ = 0;
+  next_read_index_ = 0;
+  stop_ = false;
+  for (int i = 0; i < n_threads_; ++i)
+    decoders_.emplace_back(&ImagePrefetcher::RunDecoder, this);
+}
+
+void ImagePrefetcher::Stop() {
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  free_condition_.notify_all();
+  for (auto &decoder : decoders_) decoder.join();
+  decoders_.clear();
+  slots_.clear();
+}
+
+bool ImagePrefetcher::Next(cv::Mat *image) {
+  std::unique_lock<std::mutex> lock{mutex_};
+  if (decoders_.empty() || next_read_index_ >= int(image_paths_.size()))
+    return false;
+  int index = next_read_index_;
+  auto &slot{slots_[index % capacity_]};
+  decoded_condition_.wait(lock, [&] { return slot.index == index; });
+  *image = std::move(slot.image);
+  slot = Slot{};
+  next_read_index_++;
+  free_condition_.notify_all();
+  if (image->empty()) {
+    std::cerr << "Could not read image " << image_paths_[index] << std::endl;
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::filesystem::path> ImagePrefetcher::ListImages(
+    const std::filesystem::path &directory, const std::string &prefix) {
+  std::vector<std::filesystem::path> image_paths;
+  std::error_code error_code;
+  for (auto &entry :
+       std::filesystem::directory_iterator{directory, error_code}) {
+    if (entry.is_regular_file() &&
+        entry.path().filename().string().rfind(prefix, 0) == 0)
+      image_paths.push_back(entry.path());
+  }
+  if (error_code)
+    std::cerr << "Could not list directory " << directory << std::endl;
+  std::sort(begin(image_paths), end(image_paths));
+  return image_paths;
+}
+
+int ImagePrefetcher::n_threads() const { return n_threads_; }
+
+int ImagePrefetcher::capacity() const { return capacity_; }
+
+int ImagePrefetcher::n_images() const { return int(image_paths_.size()); }
+
+void ImagePrefetcher::RunDecoder() {
+  int n_images = int(image_paths_.size());
+  while (true) {
+    int index;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      free_condition_.wait(lock, [&] {
+        return stop_ || next_decode_index_ >= n_images ||
+               next_decode_index_ < next_read_index_ + capacity_;
+      });
+      if (stop_ || next_decode_index_ >= n_images) return;
+      index = next_decode_index_++;
+    }
+    cv::Mat image{cv::imread(image_paths_[index].string(), imread_flags_)};
+    {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      auto &slot{slots_[index % capacity_]};
+      slot.index = index;
+      slot.image = std::move(image);
+    }
+    decoded_condition_.notify_all();
+  }
+}
+
+}  // namespace icg
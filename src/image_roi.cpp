@@ -0,0 +1,141 @@
+#include "pyicg/image_roi.h"
+
+namespace icg {
+
+ImageRoi::ImageRoi(float scale, int margin)
+    : scale_{std::clamp(scale, 0.01f, 1.0f)}, margin_{margin} {}
+
+void ImageRoi::set_scale(float scale) {
+  scale_ = std::clamp(scale, 0.01f, 1.0f);
+}
+
+void ImageRoi::set_margin(int margin) { margin_ = margin; }
+
+bool ImageRoi::AddBody(const std::shared_ptr<Body> &body_ptr) {
+  for (auto &ptr : body_ptrs_) {
+    if (ptr->name() == body_ptr->name()) {
+      std::cerr << "Body " << body_ptr->name() << " already exists"
+                << std::endl;
+      return false;
+    }
+  }
+  body_ptrs_.push_back(body_ptr);
+  return true;
+}
+
+bool ImageRoi::DeleteBody(const std::string &name) {
+  for (auto it = begin(body_ptrs_); it != end(body_ptrs_); ++it) {
+    if ((*it)->name() == name) {
+      body_ptrs_.erase(it);
+      return true;
+    }
+  }
+  std::cerr << "Body " << name << " not found" << std::endl;
+  return false;
+}
+
+void ImageRoi::ClearBodies() { body_ptrs_.clear(); }
+
+Intrinsics ImageRoi::ScaleIntrinsics(
+    const Intrinsics &sensor_intrinsics) const {
+  if (scale_ == 1.0f) return sensor_intrinsics;
+  Intrinsics intrinsics;
+  intrinsics.fu = sensor_intrinsics.fu * scale_;
+  intrinsics.fv = sensor_intrinsics.fv * scale_;
+  intrinsics.ppu = (sensor_intrinsics.ppu + 0.5f) * scale_ - 0.5f;
+  intrinsics.ppv = (sensor_intrinsics.ppv + 0.5f) * scale_ - 0.5f;
+  intrinsics.width = int(std::round(sensor_intrinsics.width * scale_));
+  intrinsics.height = int(std::round(sensor_intrinsics.height * scale_));
+  return intrinsics;
+}
+
+bool ImageRoi::Process(const cv::Mat &sensor_image, int output_type,
+                       double alpha, int interpolation,
+                       const Intrinsics &intrinsics,
+                       const Transform3fA &world2camera_pose, cv::Mat *image) {
+  if (sensor_image.empty()) return false;
+  cv::Rect full{0, 0, intrinsics.width, intrinsics.height};
+
+  // Previous regions are cleared instead of whole images. The buffer is
+  // reused unless another object still references the previous frame
+  if ((image_.u && image_.u->refcount > 1) || image_.size() != full.size() ||
+      image_.type() != output_type) {
+    image_ = cv::Mat{};
+    image_.create(full.size(), output_type);
+    image_.setTo(0);
+  } else if (roi_.area() > 0) {
+    image_(roi_).setTo(0);
+  }
+  roi_ = body_ptrs_.empty() ? full
+                            : ComputeRoi(intrinsics, world2camera_pose) & full;
+
+  if (roi_.area() > 0) {
+    float u_scale = float(sensor_image.cols) / float(full.width);
+    float v_scale = float(sensor_image.rows) / float(full.height);
+    int u_begin = int(std::floor(roi_.x * u_scale));
+    int v_begin = int(std::floor(roi_.y * v_scale));
+    int u_end = std::min(int(std::ceil(roi_.br().x * u_scale)),
+                         sensor_image.cols);
+    int v_end = std::min(int(std::ceil(roi_.br().y * v_scale)),
+                         sensor_image.rows);
+    cv::Mat sensor_roi{sensor_image(
+        cv::Rect{u_begin, v_begin, u_end - u_begin, v_end - v_begin})};
+    cv::Mat image_roi{image_(roi_)};
+    bool convert = sensor_image.type() != output_type || alpha != 1.0;
+    if (sensor_roi.size() == roi_.size()) {
+      if (convert)
+        sensor_roi.convertTo(image_roi, output_type, alpha);
+      else
+        sensor_roi.copyTo(image_roi);
+    } else if (convert) {
+      cv::resize(sensor_roi, resized_image_, roi_.size(), 0.0, 0.0,
+                 interpolation);
+      resized_image_.convertTo(image_roi, output_type, alpha);
+    } else {
+      cv::resize(sensor_roi, image_roi, roi_.size(), 0.0, 0.0, interpolation);
+    }
+  }
+  *image = image_;
+  return true;
+}
+
+float ImageRoi::scale() const { return scale_; }
+
+int ImageRoi::margin() const { return margin_; }
+
+const std::vector<std::shared_ptr<Body>> &ImageRoi::body_ptrs() const {
+  return body_ptrs_;
+}
+
+bool ImageRoi::active() const {
+  return scale_ != 1.0f || !body_ptrs_.empty();
+}
+
+const cv::Rect &ImageRoi::roi() const { return roi_; }
+
+cv::Rect ImageRoi::ComputeRoi(const Intrinsics &intrinsics,
+                              const Transform3fA &world2camera_pose) const {
+  cv::Rect full{0, 0, intrinsics.width, intrinsics.height};
+  cv::Rect roi;
+  for (auto &body_ptr : body_ptrs_) {
+    Eigen::Vector3f center{world2camera_pose *
+                           body_ptr->body2world_pose().translation()};
+    float radius = 0.5f * body_ptr->maximum_body_diameter();
+
+    // Bodies reaching behind the image plane may cover the whole image
+    float depth = center.z() - radius;
+    if (depth <= 0.0f) return full;
+    float u = intrinsics.fu * center.x() / center.z() + intrinsics.ppu;
+    float v = intrinsics.fv * center.y() / center.z() + intrinsics.ppv;
+    float u_radius = intrinsics.fu * radius / depth + float(margin_);
+    float v_radius = intrinsics.fv * radius / depth + float(margin_);
+    cv::Rect body_roi{cv::Point{int(std::floor(u - u_radius)),
+                                int(std::floor(v - v_radius))},
+                      cv::Point{int(std::ceil(u + u_radius)) + 1,
+                                int(std::ceil(v + v_radius)) + 1}};
+    roi = roi.area() > 0 ? roi | body_roi : body_roi;
+  }
+  return roi;
+}
+
+}  // namespace icg
@@ -0,0 +1,75 @@
+#include "pyicg/latency_recorder.h"
+
+namespace icg {
+
+LatencyRecorder::LatencyRecorder(int capacity)
+    : capacity_{std::max(capacity, 1)} {}
+
+int LatencyRecorder::AddStage(const std::string &stage) {
+  for (int i = 0; i < int(stages_.size()); ++i) {
+    if (stages_[i]->name == stage) return i;
+  }
+  auto stage_ptr{std::make_unique<Stage>()};
+  stage_ptr->name = stage;
+  stage_ptr->durations = std::make_unique<std::atomic<float>[]>(capacity_);
+  stages_.push_back(std::move(stage_ptr));
+  return int(stages_.size()) - 1;
+}
+
+void LatencyRecorder::ClearStages() { stages_.clear(); }
+
+void LatencyRecorder::Record(int stage_idx, float duration) {
+  if (stage_idx < 0 || stage_idx >= int(stages_.size())) return;
+  auto &stage{*stages_[stage_idx]};
+  uint64_t n_recorded = stage.n_recorded.load(std::memory_order_relaxed);
+  stage.durations[n_recorded % capacity_].store(duration,
+                                                std::memory_order_relaxed);
+  stage.n_recorded.store(n_recorded + 1, std::memory_order_release);
+}
+
+void LatencyRecorder::Reset() {
+  for (auto &stage_ptr : stages_)
+    stage_ptr->n_recorded.store(0, std::memory_order_release);
+}
+
+std::vector<LatencyRecorder::Statistics> LatencyRecorder::ComputeStatistics()
+    const {
+  std::vector<Statistics> statistics;
+  for (int i = 0; i < int(stages_.size()); ++i) {
+    Statistics stage_statistics;
+    stage_statistics.stage = stages_[i]->name;
+    std::vector<float> durations{samples(i)};
+    stage_statistics.count = int(durations.size());
+    if (!durations.empty()) {
+      std::sort(begin(durations), end(durations));
+      float sum = 0.0f;
+      for (float duration : durations) sum += duration;
+      stage_statistics.mean = sum / float(durations.size());
+      stage_statistics.p50 = durations[(durations.size() - 1) / 2];
+      stage_statistics.p99 = durations[(durations.size() - 1) * 99 / 100];
+      stage_statistics.max = durations.back();
+    }
+    statistics.push_back(std::move(stage_statistics));
+  }
+  return statistics;
+}
+
+int LatencyRecorder::capacity() const { return capacity_; }
+
+int LatencyRecorder::n_stages() const { return int(stages_.size()); }
+
+const std::string &LatencyRecorder::stage(int stage_idx) const {
+  return stages_[stage_idx]->name;
+}
+
+std::vector<float> LatencyRecorder::samples(int stage_idx) const {
+  const auto &stage{*stages_[stage_idx]};
+  uint64_t n_recorded = stage.n_recorded.load(std::memory_order_acquire);
+  int n_samples = int(std::min(n_recorded, uint64_t(capacity_)));
+  std::vector<float> durations(n_samples);
+  for (int i = 0; i < n_samples; ++i)
+    durations[i] = stage.durations[i].load(std::memory_order_relaxed);
+  return durations;
+}
+
+}  // namespace icg
@@ -0,0 +1,218 @@
+#include "pyicg/model_cache.h"
+
+#include <unistd.h>
+
+namespace icg {
+
+// Bump when the hashed content changes to invalidate existing files
+constexpr int kModelCacheVersion = 1;
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+ModelCache::ModelCache(const std::string &name,
+                       const std::filesystem::path &cache_directory)
+    : name_{name}, cache_directory_{cache_directory} {}
+
+bool ModelCache::SetUp() {
+  set_up_ = false;
+  std::error_code error_code;
+  std::filesystem::create_directories(cache_directory_, error_code);
+  if (!std::filesystem::is_directory(cache_directory_)) {
+    std::cerr << "Could not create cache directory " << cache_directory_
+              << " of " << name_ << std::endl;
+    return false;
+  }
+  set_up_ = true;
+  return true;
+}
+
+std::shared_ptr<SharedRegionModel> ModelCache::CreateRegionModel(
+    const std::string &name, const std::shared_ptr<Body> &body_ptr,
+    float sphere_radius, int n_divides, int n_points,
+    float max_radius_depth_offset, float stride_depth_offset,
+    bool use_random_seed, int image_size) {
+  std::filesystem::path model_path;
+  if (!ModelPath("region_model", *body_ptr, sphere_radius, n_divides, n_points,
+                 max_radius_depth_offset, stride_depth_offset,
+                 use_random_seed, image_size, &model_path))
+    return nullptr;
+  std::shared_ptr<SharedRegionModel> model_ptr;
+  if (use_random_seed) {
+    model_ptr = std::make_shared<SharedRegionModel>(
+        name, body_ptr, UniqueTemporaryPath(model_path), sphere_radius,
+        n_divides, n_points, max_radius_depth_offset, stride_depth_offset,
+        use_random_seed, image_size);
+  } else {
+    model_ptr = SharedRegionModel::Get(
+        name, body_ptr, model_path, sphere_radius, n_divides, n_points,
+        max_radius_depth_offset, stride_depth_offset, use_random_seed,
+        image_size);
+  }
+  model_ptrs_.push_back(model_ptr);
+  model_cached_.push_back(!use_random_seed);
+  body_ptrs_.push_back(body_ptr);
+  return model_ptr;
+}
+
+std::shared_ptr<SharedDepthModel> ModelCache::CreateDepthModel(
+    const std::string &name, const std::shared_ptr<Body> &body_ptr,
+    float sphere_radius, int n_divides, int n_points,
+    float max_radius_depth_offset, float stride_depth_offset,
+    bool use_random_seed, int image_size) {
+  std::filesystem::path model_path;
+  if (!ModelPath("depth_model", *body_ptr, sphere_radius, n_divides, n_points,
+                 max_radius_depth_offset, stride_depth_offset,
+                 use_random_seed, image_size, &model_path))
+    return nullptr;
+  std::shared_ptr<SharedDepthModel> model_ptr;
+  if (use_random_seed) {
+    model_ptr = std::make_shared<SharedDepthModel>(
+        name, body_ptr, UniqueTemporaryPath(model_path), sphere_radius,
+        n_divides, n_points, max_radius_depth_offset, stride_depth_offset,
+        use_random_seed, image_size);
+  } else {
+    model_ptr = SharedDepthModel::Get(
+        name, body_ptr, model_path, sphere_radius, n_divides, n_points,
+        max_radius_depth_offset, stride_depth_offset, use_random_seed,
+        image_size);
+  }
+  model_ptrs_.push_back(model_ptr);
+  model_cached_.push_back(!use_random_seed);
+  body_ptrs_.push_back(body_ptr);
+  return model_ptr;
+}
+
+bool ModelCache::SetUpModels(int n_threads) {
+  if (!set_up_) {
+    std::cerr << "Set up model cache " << name_ << " first" << std::endl;
+    return false;
+  }
+
+  // Bodies might be shared by several models and are set up beforehand
+  for (auto &body_ptr : body_ptrs_) {
+    if (!body_ptr->set_up() && !body_ptr->SetUp()) return false;
+  }
+
+  // The same shared model may have been created for several bodies
+  std::vector<int> model_idxs;
+  for (int idx = 0; idx < int(model_ptrs_.size()); ++idx) {
+    if (std::find(begin(model_ptrs_), begin(model_ptrs_) + idx,
+                  model_ptrs_[idx]) == begin(model_ptrs_) + idx)
+      model_idxs.push_back(idx);
+  }
+
+  if (n_threads <= 0) n_threads = int(std::thread::hardware_concurrency());
+  if (rendering_backend() == RenderingBackend::kGlfw) n_threads = 1;
+  n_threads = std::max(1, std::min(n_threads, int(model_idxs.size())));
+  std::atomic<int> next_model{0};
+  std::atomic<bool> success{true};
+  auto run_worker{[&] {
+    for (int i = next_model++; i < int(model_idxs.size()); i = next_model++) {
+      int idx = model_idxs[i];
+      if (!SetUpModel(model_ptrs_[idx], model_cached_[idx])) success = false;
+    }
+  }};
+  std::vector<std::thread> threads;
+  for (int i = 1; i < n_threads; ++i) threads.emplace_back(run_worker);
+  run_worker();
+  for (auto &thread : threads) thread.join();
+  return success;
+}
+
+const std::string &ModelCache::name() const { return name_; }
+
+const std::filesystem::path &ModelCache::cache_directory() const {
+  return cache_directory_;
+}
+
+bool ModelCache::set_up() const { return set_up_; }
+
+std::filesystem::path ModelCache::UniqueTemporaryPath(
+    const std::filesystem::path &path) {
+  std::stringstream suffix;
+  suffix << "." << getpid() << "_" << n_temporary_paths_++ << ".tmp";
+  return std::filesystem::path{path.string() + suffix.str()};
+}
+
+bool ModelCache::SetUpModel(const std::shared_ptr<Model> &model_ptr,
+                            bool cached) {
+  if (model_ptr->set_up()) return true;
+  const std::filesystem::path model_path{model_ptr->model_path()};
+  std::error_code error_code;
+  if (!cached) {
+    bool success = model_ptr->SetUp();
+    std::filesystem::remove(model_path, error_code);
+    return success;
+  }
+  if (std::filesystem::exists(model_path)) return model_ptr->SetUp();
+
+  // Generate into a temporary file, renamed atomically once complete, then
+  // load the final file
+  const std::filesystem::path temporary_path{UniqueTemporaryPath(model_path)};
+  model_ptr->set_model_path(temporary_path);
+  bool success = model_ptr->SetUp();
+  if (success) {
+    std::filesystem::rename(temporary_path, model_path, error_code);
+    if (error_code) {
+      std::cerr << "Could not move model to " << model_path << ": "
+                << error_code.message() << std::endl;
+      success = false;
+    }
+  }
+  std::filesystem::remove(temporary_path, error_code);
+  model_ptr->set_model_path(model_path);
+  return success && model_ptr->SetUp();
+}
+
+bool ModelCache::ModelPath(const std::string &model_type, const Body &body,
+                           float sphere_radius, int n_divides, int n_points,
+                           float max_radius_depth_offset,
+                           float stride_depth_offset, bool use_random_seed,
+                           int image_size,
+                           std::filesystem::path *model_path) const {
+  uint64_t hash = kFnvOffsetBasis;
+  if (!HashFile(body.geometry_path(), &hash)) {
+    std::cerr << "Could not read geometry " << body.geometry_path()
+              << " of body " << body.name() << std::endl;
+    return false;
+  }
+
+  std::stringstream parameters;
+  parameters << kModelCacheVersion << "|" << model_type << "|"
+             << body.geometry_unit_in_meter() << "|"
+             << body.geometry_counterclockwise() << "|"
+             << body.geometry_enable_culling() << "|"
+             << body.geometry2body_pose().matrix() << "|" << sphere_radius
+             << "|" << n_divides << "|" << n_points << "|"
+             << max_radius_depth_offset << "|" << stride_depth_offset << "|"
+             << use_random_seed << "|" << image_size;
+  const std::string parameters_string{parameters.str()};
+  HashBytes(parameters_string.data(), parameters_string.size(), &hash);
+
+  std::stringstream file_name;
+  file_name << std::hex << std::setw(16) << std::setfill('0') << hash << "_"
+            << model_type << ".bin";
+  *model_path = cache_directory_ / file_name.str();
+  return true;
+}
+
+void ModelCache::HashBytes(const char *data, size_t size, uint64_t *hash) {
+  // 64-bit FNV-1a
+  for (size_t i = 0; i < size; ++i) {
+    *hash ^= uint64_t(static_cast<unsigned char>(data[i]));
+    *hash *= kFnvPrime;
+  }
+}
+
+bool ModelCache::HashFile(const std::filesystem::path &path, uint64_t *hash) {
+  std::ifstream ifs{path, std::ios::binary};
+  if (!ifs.is_open()) return false;
+  std::vector<char> buffer(1 << 16);
+  while (ifs) {
+    ifs.read(buffer.data(), buffer.size());
+    HashBytes(buffer.data(), size_t(ifs.gcount()), hash);
+  }
+  return true;
+}
+
+}  // namespace icg
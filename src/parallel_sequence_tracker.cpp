@@ -0,0 +1,114 @@
+#include "pyicg/parallel_sequence_tracker.h"
+
+namespace icg {
+
+ParallelSequenceTracker::ParallelSequenceTracker(const std::string &name)
+    : name_{name} {}
+
+bool ParallelSequenceTracker::SetUp() {
+  set_up_ = false;
+  if (sequence_tracker_ptrs_.empty()) {
+    std::cerr << "No sequence tracker added to " << name_ << std::endl;
+    return false;
+  }
+
+  // Store initial poses that are restored before each sequence
+  initial_body2world_poses_.clear();
+  for (auto &sequence_tracker_ptr : sequence_tracker_ptrs_) {
+    if (!sequence_tracker_ptr->SetUp()) return false;
+    std::vector<Transform3fA> initial_body2world_poses;
+    for (auto &body_ptr : sequence_tracker_ptr->body_ptrs())
+      initial_body2world_poses.push_back(body_ptr->body2world_pose());
+    initial_body2world_poses_.push_back(std::move(initial_body2world_poses));
+  }
+  set_up_ = true;
+  return true;
+}
+
+bool ParallelSequenceTracker::AddSequenceTracker(
+    const std::shared_ptr<SequenceTracker> &sequence_tracker_ptr) {
+  set_up_ = false;
+  for (auto &ptr : sequence_tracker_ptrs_) {
+    if (ptr == sequence_tracker_ptr ||
+        ptr->tracker_ptr() == sequence_tracker_ptr->tracker_ptr()) {
+      std::cerr << "Tracker of sequence tracker "
+                << sequence_tracker_ptr->name() << " already used by " << name_
+                << std::endl;
+      return false;
+    }
+  }
+  sequence_tracker_ptrs_.push_back(sequence_tracker_ptr);
+  return true;
+}
+
+void ParallelSequenceTracker::ClearSequenceTrackers() {
+  set_up_ = false;
+  sequence_tracker_ptrs_.clear();
+}
+
+bool ParallelSequenceTracker::TrackSequences(
+    const std::vector<std::vector<cv::Mat>> &color_sequences,
+    const std::vector<std::vector<cv::Mat>> &depth_sequences,
+    std::vector<std::vector<std::vector<Transform3fA>>> *body2world_poses) {
+  if (!set_up_) {
+    std::cerr << "Set up parallel sequence tracker " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  if (!depth_sequences.empty() &&
+      depth_sequences.size() != color_sequences.size()) {
+    std::cerr << "Parallel sequence tracker " << name_ << " got "
+              << color_sequences.size() << " color sequences but "
+              << depth_sequences.size() << " depth sequences" << std::endl;
+    return false;
+  }
+
+  body2world_poses->assign(color_sequences.size(), {});
+  next_sequence_ = 0;
+  all_succeeded_ = true;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < int(sequence_tracker_ptrs_.size()); ++i) {
+    threads.emplace_back(&ParallelSequenceTracker::RunWorker, this, i,
+                         std::cref(color_sequences), std::cref(depth_sequences),
+                         body2world_poses);
+  }
+  for (auto &thread : threads) thread.join();
+  return all_succeeded_;
+}
+
+const std::string &ParallelSequenceTracker::name() const { return name_; }
+
+const std::vector<std::shared_ptr<SequenceTracker>>
+    &ParallelSequenceTracker::sequence_tracker_ptrs() const {
+  return sequence_tracker_ptrs_;
+}
+
+bool ParallelSequenceTracker::set_up() const { return set_up_; }
+
+void ParallelSequenceTracker::RunWorker(
+    int worker_idx, const std::vector<std::vector<cv::Mat>> &color_sequences,
+    const std::vector<std::vector<cv::Mat>> &depth_sequences,
+    std::vector<std::vector<std::vector<Transform3fA>>> *body2world_poses) {
+  static const std::vector<cv::Mat> kNoImages;
+  auto &sequence_tracker_ptr{sequence_tracker_ptrs_[worker_idx]};
+  const auto &body_ptrs{sequence_tracker_ptr->body_ptrs()};
+  const auto &initial_body2world_poses{initial_body2world_poses_[worker_idx]};
+
+  int n_sequences = int(color_sequences.size());
+  for (int idx = next_sequence_++; idx < n_sequences; idx = next_sequence_++) {
+    for (size_t i = 0; i < body_ptrs.size(); ++i)
+      body_ptrs[i]->set_body2world_pose(initial_body2world_poses[i]);
+    const auto &depth_images{depth_sequences.empty() ? kNoImages
+                                                     : depth_sequences[idx]};
+    auto &poses{(*body2world_poses)[idx]};
+    if (!sequence_tracker_ptr->TrackSequence(color_sequences[idx],
+                                             depth_images, &poses)) {
+      std::cerr << "Sequence " << idx << " failed in "
+                << sequence_tracker_ptr->name() << std::endl;
+      poses.clear();
+      all_succeeded_ = false;
+    }
+  }
+}
+
+}  // namespace icg
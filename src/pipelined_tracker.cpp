@@ -0,0 +1,256 @@
+#include "pyicg/pipelined_tracker.h"
+
+namespace icg {
+
+// Results are never waited for by the tracking thread, the oldest unpolled
+// ones are dropped beyond this capacity
+constexpr int kResultQueueCapacity = 256;
+
+PipelinedTracker::PipelinedTracker(
+    const std::string &name,
+    const std::shared_ptr<SequenceTracker> &sequence_tracker_ptr,
+    int queue_capacity, bool drop_oldest)
+    : name_{name},
+      sequence_tracker_ptr_{sequence_tracker_ptr},
+      frame_queue_{queue_capacity, drop_oldest},
+      result_queue_{kResultQueueCapacity, true} {}
+
+PipelinedTracker::~PipelinedTracker() { Stop(); }
+
+bool PipelinedTracker::SetUp() {
+  set_up_ = false;
+  if (running_) {
+    std::cerr << "Stop pipelined tracker " << name_ << " before set up"
+              << std::endl;
+    return false;
+  }
+  if (!sequence_tracker_ptr_->SetUp()) return false;
+
+  // Viewer bodies receive the poses of tracked bodies with the same name
+  const auto &body_ptrs{sequence_tracker_ptr_->body_ptrs()};
+  viewer_body_indices_.clear();
+  for (auto &viewer_body_ptr : viewer_body_ptrs_) {
+    auto it{std::find_if(begin(body_ptrs), end(body_ptrs), [&](auto &b) {
+      return b->name() == viewer_body_ptr->name();
+    })};
+    if (it == end(body_ptrs)) {
+      std::cerr << "Viewer body " << viewer_body_ptr->name()
+                << " is not tracked by " << name_ << std::endl;
+      return false;
+    }
+    if (*it == viewer_body_ptr) {
+      std::cerr << "Viewer body " << viewer_body_ptr->name() << " of "
+                << name_ << " has to be distinct from the tracked body"
+                << std::endl;
+      return false;
+    }
+    viewer_body_indices_.push_back(int(it - begin(body_ptrs)));
+  }
+  set_up_ = true;
+  return true;
+}
+
+bool PipelinedTracker::AddViewer(const std::shared_ptr<Viewer> &viewer_ptr) {
+  set_up_ = false;
+  if (std::find(begin(viewer_ptrs_), end(viewer_ptrs_), viewer_ptr) !=
+      end(viewer_ptrs_)) {
+    std::cerr << "Viewer " << viewer_ptr->name() << " already exists"
+              << std::endl;
+    return false;
+  }
+  viewer_ptrs_.push_back(viewer_ptr);
+  return true;
+}
+
+bool PipelinedTracker::AddViewerBody(const std::shared_ptr<Body> &body_ptr) {
+  set_up_ = false;
+  if (std::find(begin(viewer_body_ptrs_), end(viewer_body_ptrs_), body_ptr) !=
+      end(viewer_body_ptrs_)) {
+    std::cerr << "Viewer body " << body_ptr->name() << " already exists"
+              << std::endl;
+    return false;
+  }
+  viewer_body_ptrs_.push_back(body_ptr);
+  return true;
+}
+
+void PipelinedTracker::set_viewer_color_camera_ptr(
+    const std::shared_ptr<DummyColorCamera> &color_camera_ptr) {
+  viewer_color_camera_ptr_ = color_camera_ptr;
+}
+
+void PipelinedTracker::set_viewer_depth_camera_ptr(
+    const std::shared_ptr<DummyDepthCamera> &depth_camera_ptr) {
+  viewer_depth_camera_ptr_ = depth_camera_ptr;
+}
+
+bool PipelinedTracker::Start() {
+  if (!set_up_) {
+    std::cerr << "Set up pipelined tracker " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  if (running_) return true;
+  frame_queue_.Reset();
+  result_queue_.Reset();
+  viewer_queue_.Reset();
+  n_submitted_frames_ = 0;
+  n_dropped_frames_ = 0;
+  running_ = true;
+  tracking_thread_ = std::thread{&PipelinedTracker::RunTracking, this};
+  if (!viewer_ptrs_.empty())
+    viewer_thread_ = std::thread{&PipelinedTracker::RunViewers, this};
+  return true;
+}
+
+void PipelinedTracker::Stop() {
+  if (!running_) return;
+  frame_queue_.Close();
+  if (tracking_thread_.joinable()) tracking_thread_.join();
+  viewer_queue_.Close();
+  if (viewer_thread_.joinable()) viewer_thread_.join();
+  running_ = false;
+  CollectProcessedFrames();
+}
+
+bool PipelinedTracker::SubmitFrame(const cv::Mat &color_image,
+                                   const cv::Mat &depth_image) {
+  CollectProcessedFrames();
+  if (!running_) {
+    std::cerr << "Start pipelined tracker " << name_ << " first" << std::endl;
+    return false;
+  }
+  Frame frame{n_submitted_frames_, color_image, depth_image};
+  Frame dropped_frame;
+  bool dropped;
+  if (!frame_queue_.Push(std::move(frame), &dropped_frame, &dropped))
+    return false;
+  n_submitted_frames_++;
+  if (dropped) n_dropped_frames_++;
+  return true;
+}
+
+bool PipelinedTracker::PollResult(Result *result,
+                                  const std::chrono::milliseconds &timeout) {
+  CollectProcessedFrames();
+  return result_queue_.Pop(result, timeout);
+}
+
+const std::string &PipelinedTracker::name() const { return name_; }
+
+const std::shared_ptr<SequenceTracker>
+    &PipelinedTracker::sequence_tracker_ptr() const {
+  return sequence_tracker_ptr_;
+}
+
+const std::vector<std::shared_ptr<Viewer>> &PipelinedTracker::viewer_ptrs()
+    const {
+  return viewer_ptrs_;
+}
+
+const std::shared_ptr<DummyColorCamera>
+    &PipelinedTracker::viewer_color_camera_ptr() const {
+  return viewer_color_camera_ptr_;
+}
+
+const std::shared_ptr<DummyDepthCamera>
+    &PipelinedTracker::viewer_depth_camera_ptr() const {
+  return viewer_depth_camera_ptr_;
+}
+
+int PipelinedTracker::queue_capacity() const {
+  return int(frame_queue_.capacity());
+}
+
+bool PipelinedTracker::drop_oldest() const {
+  return frame_queue_.drop_oldest();
+}
+
+int PipelinedTracker::n_submitted_frames() const {
+  return n_submitted_frames_;
+}
+
+int PipelinedTracker::n_dropped_frames() const { return n_dropped_frames_; }
+
+int PipelinedTracker::n_dropped_results() const {
+  return int(result_queue_.n_dropped());
+}
+
+bool PipelinedTracker::running() const { return running_; }
+
+bool PipelinedTracker::set_up() const { return set_up_; }
+
+void PipelinedTracker::RunTracking() {
+  const auto &body_ptrs{sequence_tracker_ptr_->body_ptrs()};
+  Frame frame;
+  Frame previous_frame;
+  // Frame 0 might have been dropped, modalities are started on the first
+  // frame processed after Start()
+  bool first = true;
+  while (frame_queue_.Pop(&frame)) {
+    Result result;
+    result.frame_index = frame.index;
+    result.success = sequence_tracker_ptr_->TrackFrame(
+        frame.index, frame.color_image, frame.depth_image, first);
+    first = false;
+    for (auto &body_ptr : body_ptrs)
+      result.body2world_poses.push_back(body_ptr->body2world_pose());
+
+    if (!viewer_ptrs_.empty()) {
+      ViewerSnapshot dropped_snapshot;
+      bool dropped;
+      viewer_queue_.Push(ViewerSnapshot{frame, result.body2world_poses},
+                         &dropped_snapshot, &dropped);
+      if (dropped) ReleaseFrame(std::move(dropped_snapshot.frame));
+    }
+    result_queue_.Push(std::move(result));
+
+    // Cameras keep images until the next frame is set
+    ReleaseFrame(std::move(previous_frame));
+    previous_frame = std::move(frame);
+  }
+  ReleaseFrame(std::move(previous_frame));
+}
+
+void PipelinedTracker::RunViewers() {
+  ViewerSnapshot snapshot;
+  Frame previous_frame;
+  while (viewer_queue_.Pop(&snapshot)) {
+    if (viewer_color_camera_ptr_)
+      viewer_color_camera_ptr_->set_image(snapshot.frame.color_image);
+    if (viewer_depth_camera_ptr_ && !snapshot.frame.depth_image.empty())
+      viewer_depth_camera_ptr_->set_image(snapshot.frame.depth_image);
+    for (size_t i = 0; i < viewer_body_ptrs_.size(); ++i) {
+      viewer_body_ptrs_[i]->set_body2world_pose(
+          snapshot.body2world_poses[viewer_body_indices_[i]]);
+    }
+    bool display_images = false;
+    for (auto &viewer_ptr : viewer_ptrs_) {
+      viewer_ptr->UpdateViewer(snapshot.frame.index);
+      display_images |= viewer_ptr->display_images();
+    }
+    if (display_images) cv::waitKey(1);
+
+    ReleaseFrame(std::move(previous_frame));
+    previous_frame = std::move(snapshot.frame);
+  }
+  ReleaseFrame(std::move(previous_frame));
+}
+
+void PipelinedTracker::ReleaseFrame(Frame &&frame) {
+  if (frame.color_image.empty() && frame.depth_image.empty()) return;
+  const std::lock_guard<std::mutex> lock{processed_frames_mutex_};
+  processed_frames_.push_back(std::move(frame));
+  frame = Frame{};
+}
+
+void PipelinedTracker::CollectProcessedFrames() {
+  std::vector<Frame> processed_frames;
+  {
+    const std::lock_guard<std::mutex> lock{processed_frames_mutex_};
+    processed_frames.swap(processed_frames_);
+  }
+  // Images are released here, in the calling thread
+}
+
+}  // namespace icg
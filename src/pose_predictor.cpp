@@ -0,0 +1,89 @@
+#include "pyicg/pose_predictor.h"
+
+namespace icg {
+
+PosePredictor::PosePredictor(const std::string &name,
+                             const std::shared_ptr<Body> &body_ptr,
+                             float velocity_factor)
+    : name_{name}, body_ptr_{body_ptr}, velocity_factor_{velocity_factor} {}
+
+bool PosePredictor::SetUp() {
+  set_up_ = false;
+  if (!body_ptr_) {
+    std::cerr << "Body of pose predictor " << name_ << " is not set"
+              << std::endl;
+    return false;
+  }
+  Reset();
+  set_up_ = true;
+  return true;
+}
+
+void PosePredictor::set_name(const std::string &name) { name_ = name; }
+
+void PosePredictor::set_body_ptr(const std::shared_ptr<Body> &body_ptr) {
+  body_ptr_ = body_ptr;
+  set_up_ = false;
+}
+
+void PosePredictor::set_velocity_factor(float velocity_factor) {
+  velocity_factor_ = velocity_factor;
+}
+
+bool PosePredictor::PredictPose() {
+  if (!set_up_) {
+    std::cerr << "Set up pose predictor " << name_ << " first" << std::endl;
+    return false;
+  }
+
+  // Poses set from outside the tracking cycle invalidate the velocity
+  if (has_tracked_pose_ &&
+      !body_ptr_->body2world_pose().isApprox(tracked_body2world_pose_))
+    Reset();
+  if (!has_velocity_ || velocity_factor_ == 0.0f) return true;
+
+  Eigen::AngleAxisf rotation{velocity_.rotation()};
+  rotation.angle() *= velocity_factor_;
+  Transform3fA scaled_velocity{Transform3fA::Identity()};
+  scaled_velocity.rotate(rotation);
+  scaled_velocity.translation() = velocity_factor_ * velocity_.translation();
+  body_ptr_->set_body2world_pose(tracked_body2world_pose_ * scaled_velocity);
+  return true;
+}
+
+bool PosePredictor::UpdateVelocity() {
+  if (!set_up_) {
+    std::cerr << "Set up pose predictor " << name_ << " first" << std::endl;
+    return false;
+  }
+  const Transform3fA &body2world_pose{body_ptr_->body2world_pose()};
+  if (has_tracked_pose_) {
+    velocity_ = tracked_body2world_pose_.inverse() * body2world_pose;
+    has_velocity_ = true;
+  }
+  tracked_body2world_pose_ = body2world_pose;
+  has_tracked_pose_ = true;
+  return true;
+}
+
+void PosePredictor::Reset() {
+  velocity_.setIdentity();
+  has_tracked_pose_ = false;
+  has_velocity_ = false;
+}
+
+const std::string &PosePredictor::name() const { return name_; }
+
+const std::shared_ptr<Body> &PosePredictor::body_ptr() const {
+  return body_ptr_;
+}
+
+float PosePredictor::velocity_factor() const { return velocity_factor_; }
+
+bool PosePredictor::has_velocity() const { return has_velocity_; }
+
+const Transform3fA &PosePredictor::velocity() const { return velocity_; }
+
+bool PosePredictor::set_up() const { return set_up_; }
+
+}  // namespace icg
@@ -8,6 +8,7 @@
 // implicit type conversions
 #include <pybind11/stl.h>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
 #include <pybind11/chrono.h>
 #include <pybind11/stl/filesystem.h>
 // ICG
@@ -28,7 +29,17 @@
 
 // PYICG
 #include "pyicg/type_caster_utils.h"
+#include "pyicg/allocation_counter.h"
 #include "pyicg/dummy_camera.h"
+#include "pyicg/extended_tracker.h"
+#include "pyicg/pose_predictor.h"
+#include "pyicg/sequence_tracker.h"
+#include "pyicg/parallel_sequence_tracker.h"
+#include "pyicg/pipelined_tracker.h"
+#include "pyicg/rendering_backend.h"
+#include "pyicg/software_depth_renderer.h"
+#include "pyicg/shared_model.h"
+#include "pyicg/model_cache.h"
 
 namespace py = pybind11;
 // to be able to use "arg"_a shorthand
@@ -36,6 +47,48 @@ using namespace pybind11::literals;
 using namespace icg;
 using namespace Eigen;
 
+/**
+ * Long-running methods (tracking cycles, viewer rendering, model generation in SetUp, ...)
+ * are pure C++ work: they release the GIL so that other Python threads keep running.
+ * Python overrides of the Py* trampolines below reacquire it in PYBIND11_OVERRIDE_*.
+ * */
+using release_gil = py::call_guard<py::gil_scoped_release>;
+
+/**
+ * Frames given either as a stacked array (first dimension indexes frames) or as a sequence of arrays.
+ * Returned Mats share (and pin) the numpy buffers, see type_caster<cv::Mat>.
+ * */
+std::vector<cv::Mat> FramesToMats(py::handle frames)
+{
+    std::vector<cv::Mat> images;
+    if (frames.is_none())
+        return images;
+    for (py::handle frame : frames)
+        images.push_back(frame.cast<cv::Mat>());
+    return images;
+}
+
+/**
+ * Poses stored per body then per frame -> {body name: (N,4,4) float32 array}
+ * */
+py::dict PosesToDict(const std::vector<std::shared_ptr<Body>> &body_ptrs,
+                     const std::vector<std::vector<Transform3fA>> &body2world_poses)
+{
+    py::dict poses;
+    for (size_t i = 0; i < body_ptrs.size(); ++i)
+    {
+        const auto &body_poses = body2world_poses[i];
+        py::array_t<float> array({(py::ssize_t)body_poses.size(), (py::ssize_t)4, (py::ssize_t)4});
+        auto a = array.mutable_unchecked<3>();
+        for (size_t f = 0; f < body_poses.size(); ++f)
+            for (int r = 0; r < 4; ++r)
+                for (int c = 0; c < 4; ++c)
+                    a(f, r, c) = body_poses[f].matrix()(r, c);
+        poses[py::str(body_ptrs[i]->name())] = array;
+    }
+    return poses;
+}
+
 /**
  * TODO: 
  * - Read the flag USE_REALSENSE to decide whether or not to create bindings
@@ -45,29 +98,195 @@ using namespace Eigen;
 
 PYBIND11_MODULE(_pyicg_mod, m) {
 
+    // Headless backends have to be selected before any RendererGeometry is set up
+    if (DefaultRenderingBackend() != RenderingBackend::kGlfw)
+        SetRenderingBackend(DefaultRenderingBackend());
+
     ///////////////////////
     // Classes
     ///////////////////////
 
-    py::class_<Tracker>(m, "Tracker")
+    // Tracker: the tracking cycle is run step by step by ExtendedTracker, measuring stage latencies
+    py::class_<ExtendedTracker, std::shared_ptr<ExtendedTracker>>(m, "Tracker")
         .def(py::init<const std::string, int, int, bool, 
                       const std::chrono::milliseconds&, int, int>(), 
                       "name"_a, "n_corr_iterations"_a=5, "n_update_iterations"_a=2, "synchronize_cameras"_a=true, 
                       "cycle_duration"_a=std::chrono::milliseconds{33}, "visualization_time"_a=0, "viewer_time"_a=1)
-        .def("SetUp", &Tracker::SetUp, "set_up_all_objects"_a=true)
-        .def("RunTrackerProcess", &Tracker::RunTrackerProcess, "execute_detection"_a=true, "start_tracking"_a=true)
-        .def("ExecuteDetectionCycle", &Tracker::ExecuteDetectionCycle, "iteration"_a=0, "Run all detectors, iteration arg is not used")
-        .def("StartModalities", &Tracker::StartModalities, "iteration"_a)
-        .def("ExecuteTrackingCycle", &Tracker::ExecuteTrackingCycle, "iteration"_a)
-        .def("UpdateViewers", &Tracker::UpdateViewers, "iteration"_a)
-        .def("UpdateCameras", &Tracker::UpdateCameras)
+        .def("SetUp", &ExtendedTracker::SetUp, "set_up_all_objects"_a=true, release_gil())
+        .def("RunTrackerProcess", &Tracker::RunTrackerProcess, "execute_detection"_a=true, "start_tracking"_a=true, release_gil())
+        .def("ExecuteDetectionCycle", &Tracker::ExecuteDetectionCycle, "iteration"_a=0, "Run all detectors, iteration arg is not used", release_gil())
+        .def("StartModalities", &ExtendedTracker::StartModalities, "iteration"_a, release_gil())
+        .def("ExecuteTrackingCycle", &ExtendedTracker::ExecuteTrackingCycle, "iteration"_a, release_gil())
+        .def("UpdateViewers", &ExtendedTracker::UpdateViewers, "iteration"_a, release_gil())
+        .def("UpdateCameras", &ExtendedTracker::UpdateCameras, "update_all_cameras"_a=true, release_gil())
         .def("AddViewer", &Tracker::AddViewer)
         .def("AddDetector", &Tracker::AddDetector)
         .def("AddOptimizer", &Tracker::AddOptimizer)
-        .def("DetectBodies", &Tracker::DetectBodies)
+        .def("AddPosePredictor", &ExtendedTracker::AddPosePredictor)
+        .def("DeletePosePredictor", &ExtendedTracker::DeletePosePredictor)
+        .def("ClearPosePredictors", &ExtendedTracker::ClearPosePredictors)
+        .def("DetectBodies", &Tracker::DetectBodies, release_gil())
 
         .def_property("n_corr_iterations", &Tracker::n_corr_iterations, &Tracker::set_n_corr_iterations)
         .def_property("n_update_iterations", &Tracker::n_update_iterations, &Tracker::set_n_update_iterations)
+        // Modalities and optimizers processed in parallel, results are the same as with 1 thread
+        .def_property("n_threads", &ExtendedTracker::n_threads, &ExtendedTracker::set_n_threads)
+        // Occlusion renderings are reused while referenced bodies move less than this many pixels, 0 always renders
+        .def_property("rerender_threshold", &ExtendedTracker::rerender_threshold, &ExtendedTracker::set_rerender_threshold)
+        .def_property_readonly("n_renderings", &ExtendedTracker::n_renderings)
+        .def_property_readonly("n_skipped_renderings", &ExtendedTracker::n_skipped_renderings)
+        // Iterations stop per optimizer once pose updates (rad, m) or gradient norm changes are below thresholds, 0 disables
+        .def_property("convergence_rotation", &ExtendedTracker::convergence_rotation, &ExtendedTracker::set_convergence_rotation)
+        .def_property("convergence_translation", &ExtendedTracker::convergence_translation, &ExtendedTracker::set_convergence_translation)
+        .def_property("convergence_gradient", &ExtendedTracker::convergence_gradient, &ExtendedTracker::set_convergence_gradient)
+        // SetUp adds the bodies of region and depth modalities to the regions of interest of their dummy cameras
+        .def_property("image_rois", &ExtendedTracker::image_rois, &ExtendedTracker::set_image_rois)
+        .def_property_readonly("used_corr_iterations", &ExtendedTracker::used_corr_iterations)
+        .def_property_readonly("used_update_iterations", &ExtendedTracker::used_update_iterations)
+
+        // Stage latencies: {stage: {count, mean, p50, p99, max}} in ms over the last latency_capacity samples
+        .def("stats", [](const ExtendedTracker &tracker, bool samples)
+            {
+                py::dict stats;
+                const LatencyRecorder &recorder = tracker.latency_recorder();
+                std::vector<LatencyRecorder::Statistics> statistics = tracker.ComputeLatencyStatistics();
+                for (int i = 0; i < int(statistics.size()); ++i)
+                {
+                    const auto &s = statistics[i];
+                    py::dict stage("count"_a=s.count, "mean"_a=s.mean, "p50"_a=s.p50, "p99"_a=s.p99, "max"_a=s.max);
+                    if (samples)
+                        stage["samples"] = py::array_t<float>(py::cast(recorder.samples(i)));
+                    stats[py::str(s.stage)] = stage;
+                }
+                return stats;
+            },
+            "samples"_a=false)
+        .def("reset_stats", &ExtendedTracker::ResetLatencies)
+        .def_property("measure_latencies", &ExtendedTracker::measure_latencies, &ExtendedTracker::set_measure_latencies)
+        .def_property("latency_capacity", &ExtendedTracker::latency_capacity, &ExtendedTracker::set_latency_capacity)
+
+        // Whole tracking loop over recorded frames in C++, returns {body name: (N,4,4) body2world poses}
+        .def("track_sequence", [](const std::shared_ptr<ExtendedTracker> &tracker,
+                                  const std::shared_ptr<DummyColorCamera> &color_camera, py::handle color_frames,
+                                  const std::shared_ptr<DummyDepthCamera> &depth_camera, py::handle depth_frames,
+                                  bool start_modalities, bool update_viewers)
+            {
+                SequenceTracker sequence_tracker{"sequence_tracker", tracker, color_camera, depth_camera};
+                sequence_tracker.set_start_modalities(start_modalities);
+                sequence_tracker.set_update_viewers(update_viewers);
+                std::vector<cv::Mat> color_images = FramesToMats(color_frames);
+                std::vector<cv::Mat> depth_images = FramesToMats(depth_frames);
+                std::vector<std::vector<Transform3fA>> body2world_poses;
+                bool ok;
+                {
+                    py::gil_scoped_release release;
+                    ok = sequence_tracker.SetUp() && sequence_tracker.TrackSequence(color_images, depth_images, &body2world_poses);
+                }
+                if (!ok)
+                    throw std::runtime_error("Tracker.track_sequence failed, see error output");
+                return PosesToDict(sequence_tracker.body_ptrs(), body2world_poses);
+            },
+            "color_camera"_a, "color_frames"_a, "depth_camera"_a=nullptr, "depth_frames"_a=py::none(),
+            "start_modalities"_a=true, "update_viewers"_a=false)
+        ;
+
+    // SequenceTracker: one worker of ParallelSequenceTracker
+    py::class_<SequenceTracker, std::shared_ptr<SequenceTracker>>(m, "SequenceTracker")
+        .def(py::init<const std::string &, const std::shared_ptr<ExtendedTracker> &,
+                      const std::shared_ptr<DummyColorCamera> &, const std::shared_ptr<DummyDepthCamera> &>(),
+                      "name"_a, "tracker_ptr"_a, "color_camera_ptr"_a, "depth_camera_ptr"_a=nullptr)
+        .def("SetUp", &SequenceTracker::SetUp)
+        .def_property("start_modalities", &SequenceTracker::start_modalities, &SequenceTracker::set_start_modalities)
+        .def_property("update_viewers", &SequenceTracker::update_viewers, &SequenceTracker::set_update_viewers)
+        ;
+
+    // ParallelSequenceTracker: independent sequences tracked on one thread per SequenceTracker
+    py::class_<ParallelSequenceTracker, std::shared_ptr<ParallelSequenceTracker>>(m, "ParallelSequenceTracker")
+        .def(py::init<const std::string &>(), "name"_a)
+        .def("SetUp", &ParallelSequenceTracker::SetUp, release_gil())
+        .def("AddSequenceTracker", &ParallelSequenceTracker::AddSequenceTracker)
+        .def("ClearSequenceTrackers", &ParallelSequenceTracker::ClearSequenceTrackers)
+        // Returns one {body name: (N,4,4) body2world poses} per sequence, None for sequences that failed
+        .def("track_sequences", [](ParallelSequenceTracker &parallel_tracker, py::handle color_sequences, py::handle depth_sequences)
+            {
+                std::vector<std::vector<cv::Mat>> color_images;
+                std::vector<std::vector<cv::Mat>> depth_images;
+                for (py::handle color_frames : color_sequences)
+                    color_images.push_back(FramesToMats(color_frames));
+                if (!depth_sequences.is_none())
+                    for (py::handle depth_frames : depth_sequences)
+                        depth_images.push_back(FramesToMats(depth_frames));
+                std::vector<std::vector<std::vector<Transform3fA>>> body2world_poses;
+                bool set_up;
+                {
+                    py::gil_scoped_release release;
+                    set_up = parallel_tracker.set_up();
+                    if (set_up)
+                        parallel_tracker.TrackSequences(color_images, depth_images, &body2world_poses);
+                }
+                if (!set_up || body2world_poses.size() != color_images.size())
+                    throw std::runtime_error("ParallelSequenceTracker.track_sequences failed, see error output");
+
+                // Workers track bodies with the same names
+                const auto &body_ptrs = parallel_tracker.sequence_tracker_ptrs().front()->body_ptrs();
+                py::list results;
+                for (const auto &sequence_poses : body2world_poses)
+                {
+                    if (sequence_poses.size() != body_ptrs.size())
+                        results.append(py::none());
+                    else
+                        results.append(PosesToDict(body_ptrs, sequence_poses));
+                }
+                return results;
+            },
+            "color_sequences"_a, "depth_sequences"_a=py::none())
+        ;
+
+    // PipelinedTracker: tracks submitted frames on a background thread, viewers on another one
+    py::class_<PipelinedTracker, std::shared_ptr<PipelinedTracker>>(m, "PipelinedTracker")
+        .def(py::init<const std::string &, const std::shared_ptr<SequenceTracker> &, int, bool>(),
+             "name"_a, "sequence_tracker_ptr"_a, "queue_capacity"_a=2, "drop_oldest"_a=true)
+        .def("SetUp", &PipelinedTracker::SetUp, release_gil())
+        .def("AddViewer", &PipelinedTracker::AddViewer)
+        .def("AddViewerBody", &PipelinedTracker::AddViewerBody)
+        .def_property("viewer_color_camera", &PipelinedTracker::viewer_color_camera_ptr, &PipelinedTracker::set_viewer_color_camera_ptr)
+        .def_property("viewer_depth_camera", &PipelinedTracker::viewer_depth_camera_ptr, &PipelinedTracker::set_viewer_depth_camera_ptr)
+        .def("Start", &PipelinedTracker::Start)
+        .def("Stop", &PipelinedTracker::Stop, release_gil())
+        .def("submit_frame", [](PipelinedTracker &pipelined_tracker, const cv::Mat &color_image, py::handle depth_image)
+            {
+                cv::Mat depth_mat;
+                if (!depth_image.is_none())
+                    depth_mat = depth_image.cast<cv::Mat>();
+                py::gil_scoped_release release;
+                return pipelined_tracker.SubmitFrame(color_image, depth_mat);
+            },
+            "color_image"_a, "depth_image"_a=py::none())
+        // Returns None if no result arrived within timeout, else (frame index, {body name: 4x4 body2world pose} or None on failure)
+        .def("poll_result", [](PipelinedTracker &pipelined_tracker, int timeout_ms) -> py::object
+            {
+                PipelinedTracker::Result result;
+                bool received;
+                {
+                    py::gil_scoped_release release;
+                    received = pipelined_tracker.PollResult(&result, std::chrono::milliseconds{timeout_ms});
+                }
+                if (!received)
+                    return py::none();
+                if (!result.success)
+                    return py::make_tuple(result.frame_index, py::none());
+                py::dict poses;
+                const auto &body_ptrs = pipelined_tracker.sequence_tracker_ptr()->body_ptrs();
+                for (size_t i = 0; i < body_ptrs.size(); ++i)
+                    poses[py::str(body_ptrs[i]->name())] = Eigen::Matrix4f{result.body2world_poses[i].matrix()};
+                return py::make_tuple(result.frame_index, poses);
+            },
+            "timeout_ms"_a=0)
+        .def_property_readonly("running", &PipelinedTracker::running)
+        .def_property_readonly("queue_capacity", &PipelinedTracker::queue_capacity)
+        .def_property_readonly("n_submitted_frames", &PipelinedTracker::n_submitted_frames)
+        .def_property_readonly("n_dropped_frames", &PipelinedTracker::n_dropped_frames)
+        .def_property_readonly("n_dropped_results", &PipelinedTracker::n_dropped_results)
         ;
 
     // RendererGeometry
@@ -104,7 +323,7 @@ PYBIND11_MODULE(_pyicg_mod, m) {
 
     // Camera -> not constructible, just to enable automatic downcasting and binding of child classes
     py::class_<icg::Camera, PyCamera, std::shared_ptr<icg::Camera>>(m, "Camera")
-        .def("SetUp", &icg::Camera::SetUp)
+        .def("SetUp", &icg::Camera::SetUp, release_gil())
         .def_property("camera2world_pose", &icg::Camera::camera2world_pose, &icg::Camera::set_camera2world_pose)
         .def_property("world2camera_pose", &icg::Camera::world2camera_pose, &icg::Camera::set_world2camera_pose)
         ;
@@ -132,6 +351,20 @@ PYBIND11_MODULE(_pyicg_mod, m) {
         .def_property("intrinsics", &icg::DummyColorCamera::get_intrinsics, &icg::DummyColorCamera::set_intrinsics)
         .def_property("color2depth_pose", &icg::DummyColorCamera::get_color2depth_pose, &icg::DummyColorCamera::set_color2depth_pose)
         .def_property("depth2color_pose", &icg::DummyColorCamera::get_depth2color_pose, &icg::DummyColorCamera::set_depth2color_pose)
+        .def_property("recording_writer", &icg::DummyColorCamera::recording_writer_ptr, &icg::DummyColorCamera::set_recording_writer_ptr)
+        // Output images downscaled by image_scale, only copied around the bodies added with AddRoiBody (0 elsewhere)
+        .def_property("image_scale", [](const icg::DummyColorCamera &camera) { return camera.image_roi().scale(); }, &icg::DummyColorCamera::set_image_scale)
+        .def_property("roi_margin", [](const icg::DummyColorCamera &camera) { return camera.image_roi().margin(); }, &icg::DummyColorCamera::set_roi_margin)
+        .def("AddRoiBody", &icg::DummyColorCamera::AddRoiBody, "body_ptr"_a)
+        .def("DeleteRoiBody", &icg::DummyColorCamera::DeleteRoiBody, "name"_a)
+        .def("ClearRoiBodies", &icg::DummyColorCamera::ClearRoiBodies)
+        .def_property_readonly("sensor_intrinsics", &icg::DummyColorCamera::sensor_intrinsics)
+        // (x, y, width, height) of the last region of interest in the output image
+        .def_property_readonly("roi", [](const icg::DummyColorCamera &camera)
+            {
+                const cv::Rect &roi = camera.image_roi().roi();
+                return py::make_tuple(roi.x, roi.y, roi.width, roi.height);
+            })
         ;
 
     // DummyDepthCamera
@@ -142,6 +375,129 @@ PYBIND11_MODULE(_pyicg_mod, m) {
         .def_property("color2depth_pose", &icg::DummyDepthCamera::get_color2depth_pose, &icg::DummyDepthCamera::set_color2depth_pose)
         .def_property("depth2color_pose", &icg::DummyDepthCamera::get_depth2color_pose, &icg::DummyDepthCamera::set_depth2color_pose)
         .def_property("depth_scale", &icg::DummyDepthCamera::depth_scale, &icg::DummyDepthCamera::set_depth_scale)
+        .def_property("recording_writer", &icg::DummyDepthCamera::recording_writer_ptr, &icg::DummyDepthCamera::set_recording_writer_ptr)
+        // Output images downscaled by image_scale, only copied around the bodies added with AddRoiBody (0 elsewhere)
+        .def_property("image_scale", [](const icg::DummyDepthCamera &camera) { return camera.image_roi().scale(); }, &icg::DummyDepthCamera::set_image_scale)
+        .def_property("roi_margin", [](const icg::DummyDepthCamera &camera) { return camera.image_roi().margin(); }, &icg::DummyDepthCamera::set_roi_margin)
+        .def("AddRoiBody", &icg::DummyDepthCamera::AddRoiBody, "body_ptr"_a)
+        .def("DeleteRoiBody", &icg::DummyDepthCamera::DeleteRoiBody, "name"_a)
+        .def("ClearRoiBodies", &icg::DummyDepthCamera::ClearRoiBodies)
+        .def_property_readonly("sensor_intrinsics", &icg::DummyDepthCamera::sensor_intrinsics)
+        // (x, y, width, height) of the last region of interest in the output image
+        .def_property_readonly("roi", [](const icg::DummyDepthCamera &camera)
+            {
+                const cv::Rect &roi = camera.image_roi().roi();
+                return py::make_tuple(roi.x, roi.y, roi.width, roi.height);
+            })
+        ;
+
+    // RecordingWriter: binary color+depth recording, frames are added by the dummy cameras it is set to
+    py::class_<RecordingWriter, std::shared_ptr<RecordingWriter>>(m, "RecordingWriter")
+        .def(py::init<const std::filesystem::path &>(), "path"_a)
+        // Writes the header from the camera parameters and sets the writer to the cameras
+        .def("Open", [](const std::shared_ptr<RecordingWriter> &writer,
+                        const std::shared_ptr<DummyColorCamera> &color_camera,
+                        const std::shared_ptr<DummyDepthCamera> &depth_camera)
+            {
+                RecordingInfo info;
+                info.color_intrinsics = color_camera->get_intrinsics();
+                info.color2depth_pose = color_camera->get_color2depth_pose();
+                if (depth_camera)
+                {
+                    info.has_depth = true;
+                    info.depth_intrinsics = depth_camera->get_intrinsics();
+                    info.depth_scale = depth_camera->depth_scale();
+                }
+                if (!writer->Open(info))
+                    return false;
+                color_camera->set_recording_writer_ptr(writer);
+                if (depth_camera)
+                    depth_camera->set_recording_writer_ptr(writer);
+                return true;
+            },
+            "color_camera"_a, "depth_camera"_a=nullptr)
+        .def("AddColorImage", &RecordingWriter::AddColorImage, "image"_a)
+        .def("AddDepthImage", &RecordingWriter::AddDepthImage, "image"_a)
+        .def("Close", &RecordingWriter::Close, release_gil())
+        .def_property_readonly("n_frames", &RecordingWriter::n_frames)
+        ;
+
+    // RecordingReader: memory-mapped recording, images returned to python are copies
+    py::class_<RecordingReader, std::shared_ptr<RecordingReader>>(m, "RecordingReader")
+        .def(py::init<const std::filesystem::path &>(), "path"_a)
+        .def("Open", &RecordingReader::Open)
+        // Cameras keep the mapping of their current image until their next frame
+        .def("Close", &RecordingReader::Close)
+        .def_property_readonly("n_frames", &RecordingReader::n_frames)
+        .def("color_image", &RecordingReader::color_image, "frame"_a)
+        .def("depth_image", &RecordingReader::depth_image, "frame"_a)
+        .def("timestamp_ns", &RecordingReader::timestamp_ns, "frame"_a)
+        ;
+
+    // RecordingColorCamera: UpdateImage serves the next frame of a recording
+    py::class_<icg::RecordingColorCamera, icg::DummyColorCamera, std::shared_ptr<icg::RecordingColorCamera>>(m, "RecordingColorCamera")
+        .def(py::init<const std::string &, const std::shared_ptr<RecordingReader> &, bool>(),
+             "name"_a, "recording_reader"_a, "use_depth_as_world_frame"_a=false)
+        .def("UpdateImage", &icg::RecordingColorCamera::UpdateImage, "synchronized"_a=true, release_gil())
+        .def("set_next_frame", &icg::RecordingColorCamera::set_next_frame, "next_frame"_a)
+        .def_property_readonly("index", &icg::RecordingColorCamera::index)
+        ;
+
+    // RecordingDepthCamera
+    py::class_<icg::RecordingDepthCamera, icg::DummyDepthCamera, std::shared_ptr<icg::RecordingDepthCamera>>(m, "RecordingDepthCamera")
+        .def(py::init<const std::string &, const std::shared_ptr<RecordingReader> &, bool>(),
+             "name"_a, "recording_reader"_a, "use_color_as_world_frame"_a=true)
+        .def("UpdateImage", &icg::RecordingDepthCamera::UpdateImage, "synchronized"_a=true, release_gil())
+        .def("set_next_frame", &icg::RecordingDepthCamera::set_next_frame, "next_frame"_a)
+        .def_property_readonly("index", &icg::RecordingDepthCamera::index)
+        ;
+
+    // ShmFrameRing: producer side of the shared memory frame ring read by ShmColorCamera/ShmDepthCamera
+    py::class_<ShmFrameRing, std::shared_ptr<ShmFrameRing>>(m, "ShmFrameRing")
+        .def(py::init<const std::string &>(), "shm_name"_a)
+        // type: cv2.CV_8UC3 for color, cv2.CV_16UC1 for depth
+        .def("Create", &ShmFrameRing::Create, "width"_a, "height"_a, "type"_a, "n_slots"_a=4)
+        .def("Publish", &ShmFrameRing::Publish, "image"_a, "timestamp_ns"_a=0, release_gil())
+        .def("Close", &ShmFrameRing::Close)
+        .def_property_readonly("n_published_frames", &ShmFrameRing::n_published_frames)
+        ;
+
+    // ShmColorCamera: UpdateImage serves the latest frame of a ShmFrameRing filled by another process
+    py::class_<icg::ShmColorCamera, icg::DummyColorCamera, std::shared_ptr<icg::ShmColorCamera>>(m, "ShmColorCamera")
+        .def(py::init<const std::string &, const std::string &, bool, const std::chrono::milliseconds &>(),
+             "name"_a, "shm_name"_a, "use_depth_as_world_frame"_a=false, "timeout"_a=std::chrono::milliseconds{1000})
+        .def("UpdateImage", &icg::ShmColorCamera::UpdateImage, "synchronized"_a=true, release_gil())
+        .def_property_readonly("frame_index", &icg::ShmColorCamera::frame_index)
+        .def_property_readonly("timestamp_ns", &icg::ShmColorCamera::timestamp_ns)
+        ;
+
+    // ShmDepthCamera
+    py::class_<icg::ShmDepthCamera, icg::DummyDepthCamera, std::shared_ptr<icg::ShmDepthCamera>>(m, "ShmDepthCamera")
+        .def(py::init<const std::string &, const std::string &, bool, float, const std::chrono::milliseconds &>(),
+             "name"_a, "shm_name"_a, "use_color_as_world_frame"_a=true, "depth_scale"_a=0.001, "timeout"_a=std::chrono::milliseconds{1000})
+        .def("UpdateImage", &icg::ShmDepthCamera::UpdateImage, "synchronized"_a=true, release_gil())
+        .def_property_readonly("frame_index", &icg::ShmDepthCamera::frame_index)
+        .def_property_readonly("timestamp_ns", &icg::ShmDepthCamera::timestamp_ns)
+        ;
+
+    // ImageSequenceColorCamera: UpdateImage reads the next image file, decoded in advance on background threads
+    py::class_<icg::ImageSequenceColorCamera, icg::DummyColorCamera, std::shared_ptr<icg::ImageSequenceColorCamera>>(m, "ImageSequenceColorCamera")
+        .def(py::init<const std::string &, const std::filesystem::path &, const std::string &, bool, int, int>(),
+             "name"_a, "image_directory"_a, "image_prefix"_a="bgr", "use_depth_as_world_frame"_a=false,
+             "n_decode_threads"_a=2, "prefetch_capacity"_a=8)
+        .def_property("image_paths", &icg::ImageSequenceColorCamera::image_paths, &icg::ImageSequenceColorCamera::set_image_paths)
+        .def_property_readonly("index", &icg::ImageSequenceColorCamera::index)
+        .def("UpdateImage", &icg::ImageSequenceColorCamera::UpdateImage, "synchronized"_a=true, release_gil())
+        ;
+
+    // ImageSequenceDepthCamera: same for 16-bit depth images
+    py::class_<icg::ImageSequenceDepthCamera, icg::DummyDepthCamera, std::shared_ptr<icg::ImageSequenceDepthCamera>>(m, "ImageSequenceDepthCamera")
+        .def(py::init<const std::string &, const std::filesystem::path &, const std::string &, bool, float, int, int>(),
+             "name"_a, "image_directory"_a, "image_prefix"_a="depth", "use_color_as_world_frame"_a=true, "depth_scale"_a=0.001,
+             "n_decode_threads"_a=2, "prefetch_capacity"_a=8)
+        .def_property("image_paths", &icg::ImageSequenceDepthCamera::image_paths, &icg::ImageSequenceDepthCamera::set_image_paths)
+        .def_property_readonly("index", &icg::ImageSequenceDepthCamera::index)
+        .def("UpdateImage", &icg::ImageSequenceDepthCamera::UpdateImage, "synchronized"_a=true, release_gil())
         ;
 
     ///
@@ -169,8 +525,8 @@ PYBIND11_MODULE(_pyicg_mod, m) {
     py::class_<NormalColorViewer, Viewer, std::shared_ptr<icg::NormalColorViewer>>(m, "NormalColorViewer")
         .def(py::init<const std::string &, const std::shared_ptr<ColorCamera> &, const std::shared_ptr<RendererGeometry> &, float>(),
                       "name"_a, "color_camera_ptr"_a, "renderer_geometry_ptr"_a, "opacity"_a=0.5f)
-        .def("SetUp", &NormalColorViewer::SetUp)
-        .def("UpdateViewer", &NormalColorViewer::UpdateViewer, "save_index"_a)
+        .def("SetUp", &NormalColorViewer::SetUp, release_gil())
+        .def("UpdateViewer", &NormalColorViewer::UpdateViewer, "save_index"_a, release_gil())
         .def("set_opacity", &NormalColorViewer::set_opacity, "opacity"_a)
         ;
 
@@ -184,13 +540,36 @@ PYBIND11_MODULE(_pyicg_mod, m) {
     /**
      * Renderers for occlusion handling
      * */ 
-    py::class_<FocusedBasicDepthRenderer>(m, "FocusedBasicDepthRenderer")
+    // FocusedDepthRenderer -> not constructible, base expected by ModelOcclusions
+    py::class_<FocusedDepthRenderer, std::shared_ptr<FocusedDepthRenderer>>(m, "FocusedDepthRenderer");
+
+    py::class_<FocusedBasicDepthRenderer, FocusedDepthRenderer, std::shared_ptr<FocusedBasicDepthRenderer>>(m, "FocusedBasicDepthRenderer")
         // .def(py::init<const std::string &, const std::shared_ptr<RendererGeometry> &, const Transform3fA &, const Intrinsics &, int, float, float>(),
         //               "name"_a, "renderer_geometry_ptr"_a, "world2camera_pose"_a, "intrinsics"_a, "image_size"_a=200, "z_min"_a=0.01f, "z_max"_a=5.0f)       
         .def(py::init<const std::string &, const std::shared_ptr<RendererGeometry> &, const std::shared_ptr<Camera> &, int, float, float>(),
                       "name"_a, "renderer_geometry_ptr"_a, "camera_ptr"_a, "image_size"_a=200, "z_min"_a=0.01f, "z_max"_a=5.0f)
         .def("AddReferencedBody", &FocusedBasicDepthRenderer::AddReferencedBody)
         ;
+
+    // SoftwareDepthRenderer: FocusedDepthRenderer rasterizing on CPU threads, e.g. for ModelOcclusions without GPU
+    py::class_<SoftwareDepthRenderer, FocusedDepthRenderer, std::shared_ptr<SoftwareDepthRenderer>>(m, "SoftwareDepthRenderer")
+        .def(py::init<const std::string &, const std::shared_ptr<RendererGeometry> &, const std::shared_ptr<Camera> &, int, float, float, int>(),
+             "name"_a, "renderer_geometry_ptr"_a, "camera_ptr"_a, "image_size"_a=200, "z_min"_a=0.02f, "z_max"_a=10.0f, "n_threads"_a=0)
+        .def("SetUp", &SoftwareDepthRenderer::SetUp)
+        .def("AddReferencedBody", &SoftwareDepthRenderer::AddReferencedBody)
+        .def("DeleteReferencedBody", &SoftwareDepthRenderer::DeleteReferencedBody)
+        .def("ClearReferencedBodies", &SoftwareDepthRenderer::ClearReferencedBodies)
+        .def("StartRendering", &SoftwareDepthRenderer::StartRendering, release_gil())
+        .def("FetchDepthImage", &SoftwareDepthRenderer::FetchDepthImage, release_gil())
+        .def("IsBodyVisible", &SoftwareDepthRenderer::IsBodyVisible)
+        // Depth in metres at camera image coordinates (u, v), z_max if no body
+        .def("Depth", [](const SoftwareDepthRenderer &renderer, int u, int v) { return renderer.Depth(cv::Point2i{u, v}); }, "u"_a, "v"_a)
+        // uint16 OpenGL depth buffer encoding, filled by FetchDepthImage
+        .def_property_readonly("focused_depth_image", &SoftwareDepthRenderer::focused_depth_image)
+        .def_property_readonly("corner_u", &SoftwareDepthRenderer::corner_u)
+        .def_property_readonly("corner_v", &SoftwareDepthRenderer::corner_v)
+        .def_property_readonly("scale", &SoftwareDepthRenderer::scale)
+        ;
     
     // Body
     py::class_<Body, std::shared_ptr<icg::Body>>(m, "Body")
@@ -208,6 +587,18 @@ PYBIND11_MODULE(_pyicg_mod, m) {
         .def_property("world2body_pose", &Body::world2body_pose, &Body::set_world2body_pose)
         ;
 
+    // PosePredictor: constant-velocity prediction of body2world_pose at the start of each tracking cycle
+    py::class_<PosePredictor, std::shared_ptr<PosePredictor>>(m, "PosePredictor")
+        .def(py::init<const std::string &, const std::shared_ptr<Body> &, float>(),
+                      "name"_a, "body_ptr"_a, "velocity_factor"_a=1.0f)
+        .def("SetUp", &PosePredictor::SetUp)
+        .def("Reset", &PosePredictor::Reset)
+        .def_property("name", &PosePredictor::name, &PosePredictor::set_name)
+        .def_property("velocity_factor", &PosePredictor::velocity_factor, &PosePredictor::set_velocity_factor)
+        .def_property_readonly("has_velocity", &PosePredictor::has_velocity)
+        .def_property_readonly("velocity", &PosePredictor::velocity)
+        ;
+
     ///
     class PyDetector: public icg::Detector {
         public:
@@ -231,7 +622,7 @@ PYBIND11_MODULE(_pyicg_mod, m) {
                       "name"_a, "body_ptr"_a, "body2world_pose"_a)
         .def(py::init<const std::string &, const std::filesystem::path &, const std::shared_ptr<icg::Body> &>(),
                       "name"_a, "metafile_path"_a, "body_ptr"_a)
-        .def("SetUp", &StaticDetector::SetUp)
+        .def("SetUp", &StaticDetector::SetUp, release_gil())
         .def_property("body2world_pose", &StaticDetector::body2world_pose, &StaticDetector::set_body2world_pose)
         ;
 
@@ -254,6 +645,46 @@ PYBIND11_MODULE(_pyicg_mod, m) {
 
 
 
+    // SharedRegionModel: set up once, shared by several trackers/threads
+    py::class_<SharedRegionModel, RegionModel, std::shared_ptr<icg::SharedRegionModel>>(m, "SharedRegionModel")
+        .def(py::init<const std::string &, const std::shared_ptr<Body> &, const std::filesystem::path &, 
+                      float, int, int, float, float, bool, int>(),
+                      "name"_a, "body_ptr"_a, "model_path"_a, 
+                      "sphere_radius"_a=0.8f, "n_divides"_a=4, "n_points"_a=200, "max_radius_depth_offset"_a=0.05f, "stride_depth_offset"_a=0.002f, "use_random_seed"_a=false, "image_size"_a=2000)
+        .def_static("get", &SharedRegionModel::Get,
+                      "name"_a, "body_ptr"_a, "model_path"_a, 
+                      "sphere_radius"_a=0.8f, "n_divides"_a=4, "n_points"_a=200, "max_radius_depth_offset"_a=0.05f, "stride_depth_offset"_a=0.002f, "use_random_seed"_a=false, "image_size"_a=2000)
+        .def("SetUp", &SharedRegionModel::SetUp, release_gil())
+        ;
+
+    // SharedDepthModel: set up once, shared by several trackers/threads
+    py::class_<SharedDepthModel, DepthModel, std::shared_ptr<icg::SharedDepthModel>>(m, "SharedDepthModel")
+        .def(py::init<const std::string &, const std::shared_ptr<Body> &, const std::filesystem::path &, 
+                      float, int, int, float, float, bool, int>(),
+                      "name"_a, "body_ptr"_a, "model_path"_a, 
+                      "sphere_radius"_a=0.8f, "n_divides"_a=4, "n_points"_a=200, "max_radius_depth_offset"_a=0.05f, "stride_depth_offset"_a=0.002f, "use_random_seed"_a=false, "image_size"_a=2000)
+        .def_static("get", &SharedDepthModel::Get,
+                      "name"_a, "body_ptr"_a, "model_path"_a, 
+                      "sphere_radius"_a=0.8f, "n_divides"_a=4, "n_points"_a=200, "max_radius_depth_offset"_a=0.05f, "stride_depth_offset"_a=0.002f, "use_random_seed"_a=false, "image_size"_a=2000)
+        .def("SetUp", &SharedDepthModel::SetUp, release_gil())
+        ;
+
+
+    // ModelCache: model files named after a hash of geometry content and parameters
+    py::class_<ModelCache, std::shared_ptr<icg::ModelCache>>(m, "ModelCache")
+        .def(py::init<const std::string &, const std::filesystem::path &>(), "name"_a, "cache_directory"_a)
+        .def("SetUp", &ModelCache::SetUp)
+        .def("CreateRegionModel", &ModelCache::CreateRegionModel,
+                      "name"_a, "body_ptr"_a, 
+                      "sphere_radius"_a=0.8f, "n_divides"_a=4, "n_points"_a=200, "max_radius_depth_offset"_a=0.05f, "stride_depth_offset"_a=0.002f, "use_random_seed"_a=false, "image_size"_a=2000)
+        .def("CreateDepthModel", &ModelCache::CreateDepthModel,
+                      "name"_a, "body_ptr"_a, 
+                      "sphere_radius"_a=0.8f, "n_divides"_a=4, "n_points"_a=200, "max_radius_depth_offset"_a=0.05f, "stride_depth_offset"_a=0.002f, "use_random_seed"_a=false, "image_size"_a=2000)
+        .def("SetUpModels", &ModelCache::SetUpModels, "n_threads"_a=0, release_gil())
+        .def_property_readonly("cache_directory", &ModelCache::cache_directory)
+        ;
+
+
     ///
     class PyModality: public icg::Modality {
         public:
@@ -371,6 +802,21 @@ PYBIND11_MODULE(_pyicg_mod, m) {
         .def("AddModality", &Optimizer::AddModality)
         ;
 
+    ///////////////////////
+    // Functions
+    ///////////////////////
+
+    // OpenGL context creation: "glfw" (display server), "egl" or "osmesa" (headless), before any RendererGeometry.SetUp
+    m.def("set_rendering_backend", [](const std::string &name)
+        {
+            RenderingBackend backend;
+            return ParseRenderingBackend(name, &backend) && SetRenderingBackend(backend);
+        },
+        "name"_a);
+
+    // Calls to operator new since the process started, -1 unless built with COUNT_ALLOCATIONS
+    m.def("allocation_count", &AllocationCount);
+
 }   
 
 
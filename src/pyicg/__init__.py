@@ -1,25 +1,47 @@
 from ._pyicg_mod import Tracker
+from ._pyicg_mod import SequenceTracker, ParallelSequenceTracker
+from ._pyicg_mod import PipelinedTracker
 from ._pyicg_mod import RendererGeometry
 from ._pyicg_mod import RealSenseColorCamera, RealSenseDepthCamera
 from ._pyicg_mod import Intrinsics
 from ._pyicg_mod import DummyColorCamera, DummyDepthCamera
+from ._pyicg_mod import ImageSequenceColorCamera, ImageSequenceDepthCamera
+from ._pyicg_mod import RecordingWriter, RecordingReader, RecordingColorCamera, RecordingDepthCamera
+from ._pyicg_mod import ShmFrameRing, ShmColorCamera, ShmDepthCamera
 from ._pyicg_mod import NormalColorViewer, NormalDepthViewer
-from ._pyicg_mod import FocusedBasicDepthRenderer
+from ._pyicg_mod import FocusedDepthRenderer, FocusedBasicDepthRenderer
+from ._pyicg_mod import SoftwareDepthRenderer
 from ._pyicg_mod import Body
+from ._pyicg_mod import PosePredictor
 from ._pyicg_mod import StaticDetector
 from ._pyicg_mod import RegionModel, DepthModel
+from ._pyicg_mod import SharedRegionModel, SharedDepthModel
+from ._pyicg_mod import ModelCache
 from ._pyicg_mod import RegionModality, DepthModality
 from ._pyicg_mod import Optimizer
+from ._pyicg_mod import set_rendering_backend
+from ._pyicg_mod import allocation_count
 
 __all__ = ['Tracker', 
+           'SequenceTracker', 'ParallelSequenceTracker', 
+           'PipelinedTracker', 
            'RendererGeometry', 
            'RealSenseColorCamera', 'RealSenseDepthCamera', 
            'Intrinsics', 
            'DummyColorCamera', 'DummyDepthCamera', 
+           'ImageSequenceColorCamera', 'ImageSequenceDepthCamera', 
+           'RecordingWriter', 'RecordingReader', 'RecordingColorCamera', 'RecordingDepthCamera', 
+           'ShmFrameRing', 'ShmColorCamera', 'ShmDepthCamera', 
            'NormalColorViewer', 'NormalDepthViewer', 
-           'FocusedBasicDepthRenderer', 
+           'FocusedDepthRenderer', 'FocusedBasicDepthRenderer', 
+           'SoftwareDepthRenderer', 
            'Body', 
+           'PosePredictor', 
            'StaticDetector', 
            'RegionModel', 'DepthModel', 
+           'SharedRegionModel', 'SharedDepthModel', 
+           'ModelCache', 
            'RegionModality', 'DepthModality', 
-           'Optimizer',] 
+           'Optimizer', 
+           'set_rendering_backend', 
+           'allocation_count',] 
@@ -0,0 +1,320 @@
+#include "pyicg/recording.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace icg {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'Y', 'I', 'C', 'G', 'R', 'E', 'C'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kAlignment = 64;
+constexpr uint64_t kNotClosedIndexOffset = UINT64_MAX;
+
+// Little-endian on-disk header, poses are stored row-major
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t has_depth;
+  float color_intrinsics[4];  // fu, fv, ppu, ppv
+  int32_t color_size[2];      // width, height
+  float depth_intrinsics[4];
+  int32_t depth_size[2];
+  float depth_scale;
+  float color2depth_pose[16];
+  uint32_t reserved;
+  uint64_t n_frames;
+  uint64_t index_offset;
+};
+static_assert(sizeof(FileHeader) == 152, "unexpected recording header size");
+
+uint64_t Align(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+}  // namespace
+
+RecordingWriter::RecordingWriter(const std::filesystem::path &path)
+    : path_{path} {}
+
+RecordingWriter::~RecordingWriter() { Close(); }
+
+bool RecordingWriter::Open(const RecordingInfo &info) {
+  Close();
+  const std::lock_guard<std::mutex> lock{mutex_};
+  info_ = info;
+  index_.clear();
+  pending_color_image_ = cv::Mat{};
+  pending_depth_image_ = cv::Mat{};
+  ofs_.open(path_, std::ios::binary | std::ios::trunc);
+  if (!ofs_.is_open()) {
+    std::cerr << "Could not open recording " << path_ << std::endl;
+    return false;
+  }
+  end_offset_ = Align(sizeof(FileHeader));
+  if (!WriteHeader(false)) return false;
+  is_open_ = true;
+  return true;
+}
+
+bool RecordingWriter::AddColorImage(const cv::Mat &image) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  return AddImage(image, CV_8UC3, info_.color_intrinsics,
+                  &pending_color_image_);
+}
+
+bool RecordingWriter::AddDepthImage(const cv::Mat &image) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  if (!info_.has_depth) {
+    std::cerr << "Recording " << path_ << " has no depth" << std::endl;
+    return false;
+  }
+  return AddImage(image, CV_16UC1, info_.depth_intrinsics,
+                  &pending_depth_image_);
+}
+
+bool RecordingWriter::Close() {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  if (!is_open_) return true;
+  is_open_ = false;
+
+  // Index after the last payload, then final header
+  uint64_t index_offset = Align(end_offset_);
+  ofs_.seekp(index_offset);
+  ofs_.write(reinterpret_cast<const char *>(index_.data()),
+             index_.size() * sizeof(IndexEntry));
+  end_offset_ = index_offset;
+  ofs_.flush();  // index is written before the header marks the file closed
+  bool success = WriteHeader(true);
+  ofs_.close();
+  if (!success || ofs_.fail()) {
+    std::cerr << "Could not write recording " << path_ << std::endl;
+    return false;
+  }
+  return true;
+}
+
+const std::filesystem::path &RecordingWriter::path() const { return path_; }
+
+const RecordingInfo &RecordingWriter::info() const { return info_; }
+
+int RecordingWriter::n_frames() const { return int(index_.size()); }
+
+bool RecordingWriter::is_open() const { return is_open_; }
+
+bool RecordingWriter::AddImage(const cv::Mat &image, int type,
+                               const Intrinsics &intrinsics,
+                               cv::Mat *pending_image) {
+  if (!is_open_) {
+    std::cerr << "Open recording " << path_ << " first" << std::endl;
+    return false;
+  }
+  if (image.type() != type || image.cols != intrinsics.width ||
+      image.rows != intrinsics.height) {
+    std::cerr << "Image does not match recording " << path_ << std::endl;
+    return false;
+  }
+  if (pending_color_image_.empty() && pending_depth_image_.empty()) {
+    pending_timestamp_ns_ =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+  }
+  // Images without allocator wrap memory of the caller, which may be reused
+  // before the other image of the frame is added
+  if (image.u)
+    *pending_image = image;
+  else
+    image.copyTo(*pending_image);
+  if (pending_color_image_.empty()) return true;
+  if (info_.has_depth && pending_depth_image_.empty()) return true;
+  return WritePendingFrame();
+}
+
+bool RecordingWriter::WritePendingFrame() {
+  IndexEntry entry{pending_timestamp_ns_, 0, 0};
+  bool success = WritePayload(pending_color_image_, &entry.color_offset);
+  if (success && info_.has_depth)
+    success = WritePayload(pending_depth_image_, &entry.depth_offset);
+  pending_color_image_ = cv::Mat{};
+  pending_depth_image_ = cv::Mat{};
+  if (!success) {
+    std::cerr << "Could not write frame to recording " << path_ << std::endl;
+    return false;
+  }
+  index_.push_back(entry);
+  return true;
+}
+
+bool RecordingWriter::WritePayload(const cv::Mat &image, uint64_t *offset) {
+  *offset = Align(end_offset_);
+  ofs_.seekp(*offset);
+  size_t row_size = image.cols * image.elemSize();
+  for (int v = 0; v < image.rows; ++v)
+    ofs_.write(reinterpret_cast<const char *>(image.ptr(v)), row_size);
+  end_offset_ = *offset + row_size * image.rows;
+  return !ofs_.fail();
+}
+
+bool RecordingWriter::WriteHeader(bool closed) {
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.has_depth = info_.has_depth;
+  auto write_intrinsics{[](const Intrinsics &intrinsics, float *parameters,
+                           int32_t *size) {
+    parameters[0] = intrinsics.fu;
+    parameters[1] = intrinsics.fv;
+    parameters[2] = intrinsics.ppu;
+    parameters[3] = intrinsics.ppv;
+    size[0] = intrinsics.width;
+    size[1] = intrinsics.height;
+  }};
+  write_intrinsics(info_.color_intrinsics, header.color_intrinsics,
+                   header.color_size);
+  write_intrinsics(info_.depth_intrinsics, header.depth_intrinsics,
+                   header.depth_size);
+  header.depth_scale = info_.depth_scale;
+  for (int r = 0; r < 4; ++r)
+    for (int c = 0; c < 4; ++c)
+      header.color2depth_pose[r * 4 + c] = info_.color2depth_pose.matrix()(r, c);
+  header.n_frames = index_.size();
+  // Until Close(), readers reject the file as not closed
+  if (!closed)
+    header.index_offset = kNotClosedIndexOffset;
+  else
+    header.index_offset = index_.empty() ? 0 : end_offset_;
+  ofs_.seekp(0);
+  ofs_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  return !ofs_.fail();
+}
+
+RecordingReader::RecordingReader(const std::filesystem::path &path)
+    : path_{path} {}
+
+RecordingReader::~RecordingReader() { Close(); }
+
+bool RecordingReader::Open() {
+  Close();
+  int fd = open(path_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Could not open recording " << path_ << std::endl;
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      size_t(file_stat.st_size) < sizeof(FileHeader)) {
+    std::cerr << "Recording " << path_ << " is too small" << std::endl;
+    close(fd);
+    return false;
+  }
+  size_t size = size_t(file_stat.st_size);
+  void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    std::cerr << "Could not map recording " << path_ << std::endl;
+    return false;
+  }
+  mapping_ptr_.reset(static_cast<const uint8_t *>(data),
+                     [size](const uint8_t *data) {
+                       munmap(const_cast<uint8_t *>(data), size);
+                     });
+  data_ = mapping_ptr_.get();
+  size_ = size;
+
+  // Header
+  FileHeader header;
+  std::memcpy(&header, data_, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    std::cerr << path_ << " is not a recording of version " << kVersion
+              << std::endl;
+    Close();
+    return false;
+  }
+  auto read_intrinsics{[](const float *parameters, const int32_t *size) {
+    return Intrinsics{parameters[0], parameters[1], parameters[2],
+                      parameters[3], size[0],       size[1]};
+  }};
+  info_.color_intrinsics =
+      read_intrinsics(header.color_intrinsics, header.color_size);
+  info_.depth_intrinsics =
+      read_intrinsics(header.depth_intrinsics, header.depth_size);
+  info_.depth_scale = header.depth_scale;
+  info_.has_depth = header.has_depth;
+  for (int r = 0; r < 4; ++r)
+    for (int c = 0; c < 4; ++c)
+      info_.color2depth_pose.matrix()(r, c) =
+          header.color2depth_pose[r * 4 + c];
+
+  // Index, payloads are checked once to allow unchecked access
+  if (header.index_offset == kNotClosedIndexOffset ||
+      header.index_offset > size_ ||
+      header.n_frames > (size_ - header.index_offset) / sizeof(IndexEntry)) {
+    std::cerr << "Recording " << path_ << " is truncated or was not closed"
+              << std::endl;
+    Close();
+    return false;
+  }
+  index_ = reinterpret_cast<const IndexEntry *>(data_ + header.index_offset);
+  n_frames_ = int(header.n_frames);
+  size_t color_size = size_t(info_.color_intrinsics.width) *
+                      info_.color_intrinsics.height * 3;
+  size_t depth_size = size_t(info_.depth_intrinsics.width) *
+                      info_.depth_intrinsics.height * 2;
+  for (int i = 0; i < n_frames_; ++i) {
+    if (index_[i].color_offset + color_size > size_ ||
+        (info_.has_depth && index_[i].depth_offset + depth_size > size_)) {
+      std::cerr << "Recording " << path_ << " is corrupted" << std::endl;
+      Close();
+      return false;
+    }
+  }
+  return true;
+}
+
+void RecordingReader::Close() {
+  mapping_ptr_.reset();
+  data_ = nullptr;
+  size_ = 0;
+  index_ = nullptr;
+  n_frames_ = 0;
+}
+
+const std::filesystem::path &RecordingReader::path() const { return path_; }
+
+const RecordingInfo &RecordingReader::info() const { return info_; }
+
+int RecordingReader::n_frames() const { return n_frames_; }
+
+bool RecordingReader::is_open() const { return data_ != nullptr; }
+
+const std::shared_ptr<const uint8_t> &RecordingReader::mapping_ptr() const {
+  return mapping_ptr_;
+}
+
+cv::Mat RecordingReader::color_image(int frame) const {
+  if (frame < 0 || frame >= n_frames_) return cv::Mat{};
+  return cv::Mat{info_.color_intrinsics.height, info_.color_intrinsics.width,
+                 CV_8UC3,
+                 const_cast<uint8_t *>(data_ + index_[frame].color_offset)};
+}
+
+cv::Mat RecordingReader::depth_image(int frame) const {
+  if (!info_.has_depth || frame < 0 || frame >= n_frames_) return cv::Mat{};
+  return cv::Mat{info_.depth_intrinsics.height, info_.depth_intrinsics.width,
+                 CV_16UC1,
+                 const_cast<uint8_t *>(data_ + index_[frame].depth_offset)};
+}
+
+int64_t RecordingReader::timestamp_ns(int frame) const {
+  if (frame < 0 || frame >= n_frames_) return 0;
+  return index_[frame].timestamp_ns;
+}
+
+}  // namespace icg
@@ -0,0 +1,107 @@
+#include "pyicg/rendering_backend.h"
+
+#ifndef PYICG_DEFAULT_RENDERING_BACKEND
+#define PYICG_DEFAULT_RENDERING_BACKEND "glfw"
+#endif
+
+namespace icg {
+
+namespace {
+
+std::mutex backend_mutex;
+RenderingBackend current_backend = RenderingBackend::kGlfw;
+
+#if GLFW_VERSION_MAJOR > 3 || \
+    (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+// Set up for the rest of the process. RendererGeometry terminates GLFW once
+// its last instance is destroyed, and the next glfwInit() resets the context
+// creation hint, so this instance keeps GLFW initialized. It is never deleted
+RendererGeometry *holder_renderer_geometry_ptr = nullptr;
+
+bool GlfwInitialized() {
+  bool initialized = glfwGetPlatform() != 0;
+  glfwGetError(nullptr);
+  return initialized;
+}
+#endif
+
+}  // namespace
+
+bool SetRenderingBackend(RenderingBackend backend) {
+  const std::lock_guard<std::mutex> lock{backend_mutex};
+  if (backend == current_backend) return true;
+#if GLFW_VERSION_MAJOR > 3 || \
+    (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+  // Terminating GLFW would destroy the contexts of all renderer geometries
+  if (GlfwInitialized()) {
+    std::cerr << "Rendering backend cannot be changed once a renderer geometry "
+                 "was set up"
+              << std::endl;
+    return false;
+  }
+  if (backend == RenderingBackend::kGlfw) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+    current_backend = backend;
+    return true;
+  }
+
+  // No display server: null platform, contexts created by EGL or OSMesa
+  glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  if (!glfwInit()) {
+    std::cerr << "Could not initialize GLFW null platform" << std::endl;
+    glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+    return false;
+  }
+  glfwWindowHint(GLFW_CONTEXT_CREATION_API,
+                 backend == RenderingBackend::kEgl ? GLFW_EGL_CONTEXT_API
+                                                   : GLFW_OSMESA_CONTEXT_API);
+  holder_renderer_geometry_ptr =
+      new RendererGeometry{"rendering_backend_holder"};
+  if (!holder_renderer_geometry_ptr->SetUp()) {
+    std::cerr << "Could not create an OpenGL context with the "
+              << (backend == RenderingBackend::kEgl ? "egl" : "osmesa")
+              << " rendering backend" << std::endl;
+    delete holder_renderer_geometry_ptr;
+    holder_renderer_geometry_ptr = nullptr;
+    glfwTerminate();
+    glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+    return false;
+  }
+  current_backend = backend;
+  return true;
+#else
+  std::cerr << "Headless rendering requires GLFW 3.4, found "
+            << GLFW_VERSION_MAJOR << "." << GLFW_VERSION_MINOR << std::endl;
+  return false;
+#endif
+}
+
+RenderingBackend rendering_backend() {
+  const std::lock_guard<std::mutex> lock{backend_mutex};
+  return current_backend;
+}
+
+RenderingBackend DefaultRenderingBackend() {
+  RenderingBackend backend = RenderingBackend::kGlfw;
+  const char *name = std::getenv("PYICG_RENDERING_BACKEND");
+  if (name && ParseRenderingBackend(name, &backend)) return backend;
+  ParseRenderingBackend(PYICG_DEFAULT_RENDERING_BACKEND, &backend);
+  return backend;
+}
+
+bool ParseRenderingBackend(const std::string &name, RenderingBackend *backend) {
+  if (name == "glfw") {
+    *backend = RenderingBackend::kGlfw;
+  } else if (name == "egl") {
+    *backend = RenderingBackend::kEgl;
+  } else if (name == "osmesa") {
+    *backend = RenderingBackend::kOsMesa;
+  } else {
+    std::cerr << "Unknown rendering backend " << name
+              << ", expected glfw, egl, or osmesa" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace icg
@@ -0,0 +1,135 @@
+#include "pyicg/sequence_tracker.h"
+
+namespace icg {
+
+SequenceTracker::SequenceTracker(
+    const std::string &name, const std::shared_ptr<ExtendedTracker> &tracker_ptr,
+    const std::shared_ptr<DummyColorCamera> &color_camera_ptr,
+    const std::shared_ptr<DummyDepthCamera> &depth_camera_ptr)
+    : name_{name},
+      tracker_ptr_{tracker_ptr},
+      color_camera_ptr_{color_camera_ptr},
+      depth_camera_ptr_{depth_camera_ptr} {}
+
+bool SequenceTracker::SetUp() {
+  set_up_ = false;
+  if (!tracker_ptr_ || !tracker_ptr_->set_up()) {
+    std::cerr << "Tracker of sequence tracker " << name_ << " was not set up"
+              << std::endl;
+    return false;
+  }
+  if (!color_camera_ptr_ || !color_camera_ptr_->set_up()) {
+    std::cerr << "Color camera of sequence tracker " << name_
+              << " was not set up" << std::endl;
+    return false;
+  }
+  if (depth_camera_ptr_ && !depth_camera_ptr_->set_up()) {
+    std::cerr << "Depth camera " << depth_camera_ptr_->name()
+              << " was not set up" << std::endl;
+    return false;
+  }
+
+  // Collect tracked bodies in optimizer order
+  body_ptrs_.clear();
+  for (auto &optimizer_ptr : tracker_ptr_->optimizer_ptrs()) {
+    for (auto &modality_ptr : optimizer_ptr->modality_ptrs()) {
+      const auto &body_ptr{modality_ptr->body_ptr()};
+      if (std::find(begin(body_ptrs_), end(body_ptrs_), body_ptr) ==
+          end(body_ptrs_))
+        body_ptrs_.push_back(body_ptr);
+    }
+  }
+  set_up_ = true;
+  return true;
+}
+
+void SequenceTracker::set_start_modalities(bool start_modalities) {
+  start_modalities_ = start_modalities;
+}
+
+void SequenceTracker::set_update_viewers(bool update_viewers) {
+  update_viewers_ = update_viewers;
+}
+
+bool SequenceTracker::TrackSequence(
+    const std::vector<cv::Mat> &color_images,
+    const std::vector<cv::Mat> &depth_images,
+    std::vector<std::vector<Transform3fA>> *body2world_poses) {
+  if (!set_up_) {
+    std::cerr << "Set up sequence tracker " << name_ << " first" << std::endl;
+    return false;
+  }
+  if (depth_camera_ptr_ && depth_images.size() != color_images.size()) {
+    std::cerr << "Sequence tracker " << name_ << " got "
+              << color_images.size() << " color images but "
+              << depth_images.size() << " depth images" << std::endl;
+    return false;
+  }
+
+  int n_frames = int(color_images.size());
+  body2world_poses->assign(body_ptrs_.size(), {});
+  for (auto &poses : *body2world_poses) poses.reserve(n_frames);
+
+  for (int iteration = 0; iteration < n_frames; ++iteration) {
+    static const cv::Mat kNoImage;
+    const cv::Mat &depth_image{depth_camera_ptr_ ? depth_images[iteration]
+                                                 : kNoImage};
+    if (!TrackFrame(iteration, color_images[iteration], depth_image))
+      return false;
+    for (size_t i = 0; i < body_ptrs_.size(); ++i)
+      (*body2world_poses)[i].push_back(body_ptrs_[i]->body2world_pose());
+  }
+  return true;
+}
+
+bool SequenceTracker::TrackFrame(int iteration, const cv::Mat &color_image,
+                                 const cv::Mat &depth_image) {
+  return TrackFrame(iteration, color_image, depth_image, iteration == 0);
+}
+
+bool SequenceTracker::TrackFrame(int iteration, const cv::Mat &color_image,
+                                 const cv::Mat &depth_image, bool first_frame) {
+  if (!set_up_) {
+    std::cerr << "Set up sequence tracker " << name_ << " first" << std::endl;
+    return false;
+  }
+
+  // Same steps as Tracker::RunTrackerProcess, without detection
+  color_camera_ptr_->set_image(color_image);
+  if (depth_camera_ptr_) depth_camera_ptr_->set_image(depth_image);
+  if (!tracker_ptr_->UpdateCameras(true)) return false;
+  if (first_frame && start_modalities_)
+    if (!tracker_ptr_->StartModalities(iteration)) return false;
+  if (!tracker_ptr_->ExecuteTrackingCycle(iteration)) return false;
+  if (update_viewers_)
+    if (!tracker_ptr_->UpdateViewers(iteration)) return false;
+  return true;
+}
+
+const std::string &SequenceTracker::name() const { return name_; }
+
+const std::shared_ptr<ExtendedTracker> &SequenceTracker::tracker_ptr() const {
+  return tracker_ptr_;
+}
+
+const std::shared_ptr<DummyColorCamera> &SequenceTracker::color_camera_ptr()
+    const {
+  return color_camera_ptr_;
+}
+
+const std::shared_ptr<DummyDepthCamera> &SequenceTracker::depth_camera_ptr()
+    const {
+  return depth_camera_ptr_;
+}
+
+const std::vector<std::shared_ptr<Body>> &SequenceTracker::body_ptrs() const {
+  return body_ptrs_;
+}
+
+bool SequenceTracker::start_modalities() const { return start_modalities_; }
+
+bool SequenceTracker::update_viewers() const { return update_viewers_; }
+
+bool SequenceTracker::set_up() const { return set_up_; }
+
+}  // namespace icg
@@ -0,0 +1,286 @@
+#include "pyicg/shm_frame_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <new>
+
+namespace icg {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'Y', 'I', 'C', 'G', 'S', 'H', 'M'};
+constexpr uint32_t kVersion = 2;
+constexpr size_t kAlignment = 64;
+
+size_t Align(size_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+}  // namespace
+
+// Shared by producer and consumer processes
+struct alignas(64) ShmFrameRing::RingHeader {
+  char magic[8];
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  int32_t type;
+  int32_t n_slots;
+  uint64_t step;
+  uint64_t slot_stride;
+  std::atomic<int32_t> latest_slot{-1};
+  std::atomic<int32_t> claimed_slot{-1};    // image held by the consumer
+  std::atomic<int32_t> acquiring_slot{-1};  // checked by the consumer
+  std::atomic<uint64_t> n_published{0};
+};
+
+struct alignas(64) ShmFrameRing::SlotHeader {
+  std::atomic<uint64_t> sequence{0};  // odd while the slot is written
+  uint64_t frame_index = 0;
+  int64_t timestamp_ns = 0;
+};
+
+static_assert(std::atomic<int32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory atomics have to be lock-free");
+
+ShmFrameRing::ShmFrameRing(const std::string &shm_name)
+    : shm_name_{shm_name} {}
+
+ShmFrameRing::~ShmFrameRing() { Close(); }
+
+bool ShmFrameRing::Create(int width, int height, int type, int n_slots) {
+  Close();
+  if (width <= 0 || height <= 0 || n_slots < 2) {
+    std::cerr << "Invalid size or number of slots for shared memory "
+              << shm_name_ << std::endl;
+    return false;
+  }
+  size_t step = size_t(width) * CV_ELEM_SIZE(type);
+  size_t slot_stride = Align(sizeof(SlotHeader) + step * height);
+  size_t size = Align(sizeof(RingHeader)) + slot_stride * n_slots;
+
+  int fd = shm_open(shm_name_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+  if (fd < 0) {
+    std::cerr << "Could not create shared memory " << shm_name_ << std::endl;
+    return false;
+  }
+  if (ftruncate(fd, off_t(size)) != 0 || !Map(fd, size)) {
+    std::cerr << "Could not allocate shared memory " << shm_name_ << std::endl;
+    close(fd);
+    shm_unlink(shm_name_.c_str());
+    return false;
+  }
+  close(fd);
+  is_producer_ = true;
+
+  header_ = new (data_) RingHeader{};
+  header_->version = kVersion;
+  header_->width = width;
+  header_->height = height;
+  header_->type = type;
+  header_->n_slots = n_slots;
+  header_->step = step;
+  header_->slot_stride = slot_stride;
+  for (int i = 0; i < n_slots; ++i) new (slot(i)) SlotHeader{};
+
+  // Consumers only accept the ring once the magic is visible
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+  return true;
+}
+
+bool ShmFrameRing::Publish(const cv::Mat &image, int64_t timestamp_ns) {
+  if (!is_producer_ || !header_) {
+    std::cerr << "Create shared memory " << shm_name_ << " first" << std::endl;
+    return false;
+  }
+  if (image.type() != header_->type || image.cols != header_->width ||
+      image.rows != header_->height) {
+    std::cerr << "Image does not match shared memory " << shm_name_
+              << std::endl;
+    return false;
+  }
+
+  // Next slot that is neither held nor being acquired by the consumer. The
+  // claims are checked again once the slot is marked as written: either the
+  // producer sees a claim and gives the slot back, or the consumer sees the
+  // odd sequence and retries
+  int n_slots = header_->n_slots;
+  int slot_idx = header_->latest_slot.load(std::memory_order_relaxed);
+  for (int attempt = 0; attempt < 2 * n_slots; ++attempt) {
+    slot_idx = (slot_idx + 1) % n_slots;
+    if (IsClaimed(slot_idx)) continue;
+    SlotHeader *slot_header{slot(slot_idx)};
+    uint64_t sequence = slot_header->sequence.load(std::memory_order_relaxed);
+    slot_header->sequence.store(sequence + 1);
+    if (IsClaimed(slot_idx)) {
+      slot_header->sequence.store(sequence);
+      continue;
+    }
+
+    uint8_t *data{slot_data(slot_idx)};
+    size_t step = header_->step;
+    for (int v = 0; v < image.rows; ++v)
+      std::memcpy(data + v * step, image.ptr(v), step);
+    uint64_t frame_index =
+        header_->n_published.load(std::memory_order_relaxed);
+    slot_header->frame_index = frame_index;
+    slot_header->timestamp_ns = timestamp_ns;
+    slot_header->sequence.store(sequence + 2, std::memory_order_release);
+    header_->latest_slot.store(slot_idx, std::memory_order_release);
+    header_->n_published.store(frame_index + 1, std::memory_order_release);
+    return true;
+  }
+  return false;
+}
+
+bool ShmFrameRing::Open() {
+  Close();
+  int fd = shm_open(shm_name_.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    std::cerr << "Could not open shared memory " << shm_name_ << std::endl;
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      size_t(file_stat.st_size) < Align(sizeof(RingHeader)) ||
+      !Map(fd, size_t(file_stat.st_size))) {
+    std::cerr << "Could not map shared memory " << shm_name_ << std::endl;
+    close(fd);
+    return false;
+  }
+  close(fd);
+
+  header_ = reinterpret_cast<RingHeader *>(data_);
+  bool valid = std::memcmp(header_->magic, kMagic, sizeof(kMagic)) == 0;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (!valid || header_->version != kVersion ||
+      Align(sizeof(RingHeader)) + header_->slot_stride * header_->n_slots >
+          size_) {
+    std::cerr << "Shared memory " << shm_name_
+              << " is not a frame ring of version " << kVersion << std::endl;
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool ShmFrameRing::AcquireLatest(cv::Mat *image, uint64_t *frame_index,
+                                 int64_t *timestamp_ns) {
+  if (!header_) return false;
+
+  // The latest slot is only written again once the producer laps the ring,
+  // a newer slot is then tried after yielding to the producer. Candidates are
+  // checked under a separate claim, so the slot held so far stays claimed
+  // until it is replaced and is still valid if all attempts fail
+  for (int attempt = 0; attempt < header_->n_slots; ++attempt) {
+    int slot_idx = header_->latest_slot.load(std::memory_order_acquire);
+    if (slot_idx < 0) return false;
+    header_->acquiring_slot.store(slot_idx);
+    SlotHeader *slot_header{slot(slot_idx)};
+    uint64_t sequence = slot_header->sequence.load();
+    if (sequence % 2 == 1) {
+      header_->acquiring_slot.store(-1);
+      std::this_thread::yield();
+      continue;
+    }
+    header_->claimed_slot.store(slot_idx);
+    header_->acquiring_slot.store(-1);
+    if (frame_index) *frame_index = slot_header->frame_index;
+    if (timestamp_ns) *timestamp_ns = slot_header->timestamp_ns;
+    *image = cv::Mat{header_->height, header_->width, header_->type,
+                     slot_data(slot_idx), size_t(header_->step)};
+    return true;
+  }
+  return false;
+}
+
+bool ShmFrameRing::WaitForFrame(uint64_t min_frame_index,
+                                const std::chrono::milliseconds &timeout,
+                                cv::Mat *image, uint64_t *frame_index,
+                                int64_t *timestamp_ns) {
+  if (!header_) return false;
+
+  // The claim is only moved once a frame that is new enough was acquired, so
+  // the current slot stays valid and outputs are unchanged on failure
+  auto deadline{std::chrono::steady_clock::now() + timeout};
+  while (true) {
+    if (header_->n_published.load(std::memory_order_acquire) >
+        min_frame_index) {
+      cv::Mat acquired_image;
+      uint64_t acquired_frame_index;
+      int64_t acquired_timestamp_ns;
+      if (AcquireLatest(&acquired_image, &acquired_frame_index,
+                        &acquired_timestamp_ns)) {
+        *image = acquired_image;
+        if (frame_index) *frame_index = acquired_frame_index;
+        if (timestamp_ns) *timestamp_ns = acquired_timestamp_ns;
+        return true;
+      }
+    }
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(std::chrono::microseconds{100});
+  }
+}
+
+void ShmFrameRing::Release() {
+  if (header_) header_->claimed_slot.store(-1);
+}
+
+void ShmFrameRing::Close() {
+  if (!data_) return;
+  if (!is_producer_) Release();
+  munmap(data_, size_);
+  if (is_producer_) shm_unlink(shm_name_.c_str());
+  data_ = nullptr;
+  size_ = 0;
+  header_ = nullptr;
+  is_producer_ = false;
+}
+
+const std::string &ShmFrameRing::shm_name() const { return shm_name_; }
+
+bool ShmFrameRing::is_open() const { return header_ != nullptr; }
+
+bool ShmFrameRing::is_producer() const { return is_producer_; }
+
+int ShmFrameRing::width() const { return header_ ? header_->width : 0; }
+
+int ShmFrameRing::height() const { return header_ ? header_->height : 0; }
+
+int ShmFrameRing::type() const { return header_ ? header_->type : 0; }
+
+int ShmFrameRing::n_slots() const { return header_ ? header_->n_slots : 0; }
+
+uint64_t ShmFrameRing::n_published_frames() const {
+  return header_ ? header_->n_published.load(std::memory_order_acquire) : 0;
+}
+
+bool ShmFrameRing::Map(int fd, size_t size) {
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) return false;
+  data_ = static_cast<uint8_t *>(data);
+  size_ = size;
+  return true;
+}
+
+bool ShmFrameRing::IsClaimed(int slot_idx) const {
+  return header_->claimed_slot.load() == slot_idx ||
+         header_->acquiring_slot.load() == slot_idx;
+}
+
+ShmFrameRing::SlotHeader *ShmFrameRing::slot(int slot_idx) const {
+  return reinterpret_cast<SlotHeader *>(
+      data_ + Align(sizeof(RingHeader)) + header_->slot_stride * slot_idx);
+}
+
+uint8_t *ShmFrameRing::slot_data(int slot_idx) const {
+  return reinterpret_cast<uint8_t *>(slot(slot_idx)) + sizeof(SlotHeader);
+}
+
+}  // namespace icg
@@ -0,0 +1,307 @@
+#include "pyicg/software_depth_renderer.h"
+
+namespace icg {
+
+constexpr int kTileSize = 16;
+constexpr uchar kNoBody = 255;
+
+SoftwareDepthRenderer::SoftwareDepthRenderer(
+    const std::string &name,
+    const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
+    const std::shared_ptr<Camera> &camera_ptr, int image_size, float z_min,
+    float z_max, int n_threads)
+    : FocusedDepthRenderer{name,       renderer_geometry_ptr, camera_ptr,
+                           image_size, z_min,                 z_max} {
+  if (n_threads <= 0) n_threads = int(std::thread::hardware_concurrency());
+  thread_pool_ = std::make_unique<ThreadPool>(std::max(n_threads, 1));
+}
+
+bool SoftwareDepthRenderer::SetUp() {
+  set_up_ = false;
+  if (!renderer_geometry_ptr_->set_up()) {
+    std::cerr << "Set up renderer geometry "
+              << renderer_geometry_ptr_->name() << " first" << std::endl;
+    return false;
+  }
+  if (camera_ptr_) {
+    if (!camera_ptr_->set_up()) {
+      std::cerr << "Set up camera " << camera_ptr_->name() << " first"
+                << std::endl;
+      return false;
+    }
+    intrinsics_ = camera_ptr_->intrinsics();
+    world2camera_pose_ = camera_ptr_->world2camera_pose();
+    camera2world_pose_ = camera_ptr_->camera2world_pose();
+  }
+  if (referenced_body_ptrs_.size() >= kNoBody) {
+    std::cerr << "Too many referenced bodies for renderer " << name_
+              << std::endl;
+    return false;
+  }
+  if (!LoadVertices()) return false;
+
+  // Same encoding as the OpenGL depth buffer, depth = a / (b - value)
+  projection_term_a_ = z_max_ * z_min_ * 65535.0f / (z_max_ - z_min_);
+  projection_term_b_ = z_max_ * 65535.0f / (z_max_ - z_min_);
+  focused_depth_image_.create(image_size_, image_size_, CV_16UC1);
+  metric_depth_image_.create(image_size_, image_size_, CV_32FC1);
+  body_idx_image_.create(image_size_, image_size_, CV_8UC1);
+  focused_depth_image_.setTo(65535);
+  metric_depth_image_.setTo(0.0f);
+  body_idx_image_.setTo(kNoBody);
+  n_tiles_per_row_ = (image_size_ + kTileSize - 1) / kTileSize;
+  body_visible_.assign(referenced_body_ptrs_.size(), false);
+  set_up_ = true;
+  return true;
+}
+
+bool SoftwareDepthRenderer::StartRendering() {
+  if (!set_up_) {
+    std::cerr << "Set up software depth renderer " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  if (camera_ptr_) {
+    world2camera_pose_ = camera_ptr_->world2camera_pose();
+    camera2world_pose_ = camera_ptr_->camera2world_pose();
+  }
+  metric_depth_image_.setTo(0.0f);
+  body_idx_image_.setTo(kNoBody);
+  std::fill(begin(body_visible_), end(body_visible_), false);
+  if (!CalculateFocus()) return true;
+
+  AssembleTriangles();
+  thread_pool_->ParallelFor(n_tiles_per_row_ * n_tiles_per_row_,
+                            [&](int tile_idx) { RasterizeTile(tile_idx); });
+  for (int v = 0; v < image_size_; ++v) {
+    const uchar *body_idxs = body_idx_image_.ptr<uchar>(v);
+    for (int u = 0; u < image_size_; ++u)
+      if (body_idxs[u] != kNoBody) body_visible_[body_idxs[u]] = true;
+  }
+  return true;
+}
+
+bool SoftwareDepthRenderer::FetchDepthImage() {
+  if (!set_up_) {
+    std::cerr << "Set up software depth renderer " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+
+  // Pixels without body are at the far plane, like a cleared depth buffer
+  thread_pool_->ParallelFor(image_size_, [&](int v) {
+    const float *depths = metric_depth_image_.ptr<float>(v);
+    ushort *values = focused_depth_image_.ptr<ushort>(v);
+    for (int u = 0; u < image_size_; ++u) {
+      if (depths[u] == 0.0f) {
+        values[u] = 65535;
+        continue;
+      }
+      float value = projection_term_b_ - projection_term_a_ / depths[u];
+      values[u] = ushort(std::clamp(value + 0.5f, 0.0f, 65535.0f));
+    }
+  });
+  return true;
+}
+
+int SoftwareDepthRenderer::n_threads() const {
+  return thread_pool_->n_threads();
+}
+
+float SoftwareDepthRenderer::corner_u() const { return corner_u_; }
+
+float SoftwareDepthRenderer::corner_v() const { return corner_v_; }
+
+float SoftwareDepthRenderer::scale() const { return scale_; }
+
+bool SoftwareDepthRenderer::IsBodyVisible(const std::string &name) const {
+  for (size_t i = 0; i < referenced_body_ptrs_.size(); ++i) {
+    if (referenced_body_ptrs_[i]->name() == name && i < body_visible_.size())
+      return body_visible_[i];
+  }
+  return false;
+}
+
+bool SoftwareDepthRenderer::LoadVertices() {
+  // Vertex buffers hold triangle lists in the body frame, with interleaved
+  // attributes that start with the position
+  const auto &render_data_bodies{renderer_geometry_ptr_->render_data_bodies()};
+  vertices_.assign(referenced_body_ptrs_.size(), {});
+  std::vector<float> buffer;
+  const std::lock_guard<std::mutex> lock{renderer_geometry_ptr_->mutex()};
+  renderer_geometry_ptr_->MakeContextCurrent();
+  bool success = true;
+  for (size_t b = 0; b < referenced_body_ptrs_.size(); ++b) {
+    const std::string &body_name{referenced_body_ptrs_[b]->name()};
+    auto it{std::find_if(
+        begin(render_data_bodies), end(render_data_bodies),
+        [&](const auto &r) { return r.body_ptr->name() == body_name; })};
+    if (it == end(render_data_bodies) || it->n_vertices == 0) {
+      std::cerr << "Body " << body_name << " was not added to renderer geometry "
+                << renderer_geometry_ptr_->name() << std::endl;
+      success = false;
+      break;
+    }
+    GLint buffer_size = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, it->vbo);
+    glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &buffer_size);
+    buffer.resize(size_t(buffer_size) / sizeof(float));
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, buffer_size, buffer.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    size_t stride = buffer.size() / it->n_vertices;
+    if (stride < 3) {
+      std::cerr << "Could not read vertices of body " << body_name
+                << std::endl;
+      success = false;
+      break;
+    }
+    auto &vertices{vertices_[b]};
+    vertices.resize(it->n_vertices / 3 * 3);
+    for (size_t i = 0; i < vertices.size(); ++i)
+      vertices[i] = Eigen::Vector3f{buffer[i * stride], buffer[i * stride + 1],
+                                    buffer[i * stride + 2]};
+  }
+  renderer_geometry_ptr_->DetachContext();
+  return success;
+}
+
+bool SoftwareDepthRenderer::CalculateFocus() {
+  // Square region around the projected bounding spheres of all bodies
+  const Intrinsics &intrinsics{intrinsics_};
+  float u_min = std::numeric_limits<float>::max(), v_min = u_min;
+  float u_max = std::numeric_limits<float>::lowest(), v_max = u_max;
+  for (auto &body_ptr : referenced_body_ptrs_) {
+    Eigen::Vector3f center{
+        (world2camera_pose_ * body_ptr->body2world_pose()).translation()};
+    if (center.z() < z_min_) continue;
+    float u = intrinsics.fu * center.x() / center.z() + intrinsics.ppu;
+    float v = intrinsics.fv * center.y() / center.z() + intrinsics.ppv;
+    float radius = std::max(intrinsics.fu, intrinsics.fv) * 0.5f *
+                   body_ptr->maximum_body_diameter() / center.z();
+    u_min = std::min(u_min, u - radius);
+    u_max = std::max(u_max, u + radius);
+    v_min = std::min(v_min, v - radius);
+    v_max = std::max(v_max, v + radius);
+  }
+  if (u_min > u_max) return false;
+  float size = std::max(u_max - u_min, v_max - v_min);
+  corner_u_ = 0.5f * (u_min + u_max - size);
+  corner_v_ = 0.5f * (v_min + v_max - size);
+  scale_ = float(image_size_) / size;
+  return true;
+}
+
+void SoftwareDepthRenderer::AssembleTriangles() {
+  const Intrinsics &intrinsics{intrinsics_};
+  triangles_.clear();
+  for (auto &tile_triangle_idxs : tile_triangle_idxs_)
+    tile_triangle_idxs.clear();
+  tile_triangle_idxs_.resize(n_tiles_per_row_ * n_tiles_per_row_);
+
+  for (size_t b = 0; b < referenced_body_ptrs_.size(); ++b) {
+    Transform3fA body2camera_pose{world2camera_pose_ *
+                                  referenced_body_ptrs_[b]->body2world_pose()};
+    const auto &vertices{vertices_[b]};
+    camera_vertices_.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+      camera_vertices_[i] = body2camera_pose * vertices[i];
+
+    for (size_t first = 0; first < camera_vertices_.size(); first += 3) {
+      ScreenTriangle screen_triangle;
+      Eigen::Vector2f *points[3]{&screen_triangle.p0, &screen_triangle.p1,
+                                 &screen_triangle.p2};
+      float *inv_zs[3]{&screen_triangle.inv_z0, &screen_triangle.inv_z1,
+                       &screen_triangle.inv_z2};
+      bool in_range = true;
+      bool in_front = false;
+      for (int i = 0; i < 3; ++i) {
+        const Eigen::Vector3f &point{camera_vertices_[first + i]};
+        in_range &= point.z() >= z_min_;
+        in_front |= point.z() <= z_max_;
+        *inv_zs[i] = 1.0f / point.z();
+        *points[i] = Eigen::Vector2f{
+            (intrinsics.fu * point.x() * *inv_zs[i] + intrinsics.ppu -
+             corner_u_) * scale_,
+            (intrinsics.fv * point.y() * *inv_zs[i] + intrinsics.ppv -
+             corner_v_) * scale_};
+      }
+      if (!in_range || !in_front) continue;
+      screen_triangle.body_idx = int(b);
+
+      // Bin into tiles covered by the bounding box
+      Eigen::Vector2f min{screen_triangle.p0.cwiseMin(screen_triangle.p1)
+                              .cwiseMin(screen_triangle.p2)};
+      Eigen::Vector2f max{screen_triangle.p0.cwiseMax(screen_triangle.p1)
+                              .cwiseMax(screen_triangle.p2)};
+      if (max.x() < 0.0f || max.y() < 0.0f || min.x() >= image_size_ ||
+          min.y() >= image_size_)
+        continue;
+      int tile_u_min = std::max(int(min.x()), 0) / kTileSize;
+      int tile_v_min = std::max(int(min.y()), 0) / kTileSize;
+      int tile_u_max = std::min(int(max.x()), image_size_ - 1) / kTileSize;
+      int tile_v_max = std::min(int(max.y()), image_size_ - 1) / kTileSize;
+      int triangle_idx = int(triangles_.size());
+      triangles_.push_back(screen_triangle);
+      for (int tv = tile_v_min; tv <= tile_v_max; ++tv)
+        for (int tu = tile_u_min; tu <= tile_u_max; ++tu)
+          tile_triangle_idxs_[tv * n_tiles_per_row_ + tu].push_back(
+              triangle_idx);
+    }
+  }
+}
+
+void SoftwareDepthRenderer::RasterizeTile(int tile_idx) {
+  int tile_u = (tile_idx % n_tiles_per_row_) * kTileSize;
+  int tile_v = (tile_idx / n_tiles_per_row_) * kTileSize;
+  int tile_u_end = std::min(tile_u + kTileSize, image_size_);
+  int tile_v_end = std::min(tile_v + kTileSize, image_size_);
+
+  // Triangles are processed in submission order, so results do not depend on
+  // the number of threads
+  for (int triangle_idx : tile_triangle_idxs_[tile_idx]) {
+    const ScreenTriangle &t{triangles_[triangle_idx]};
+    float area = (t.p1.x() - t.p0.x()) * (t.p2.y() - t.p0.y()) -
+                 (t.p1.y() - t.p0.y()) * (t.p2.x() - t.p0.x());
+    if (std::abs(area) < 1e-8f) continue;
+    float inv_area = 1.0f / area;
+
+    // Barycentric coordinates are affine in pixel coordinates
+    auto edge_coefficients{[&](const Eigen::Vector2f &a,
+                               const Eigen::Vector2f &b) {
+      return Eigen::Vector3f{(a.y() - b.y()) * inv_area,
+                             (b.x() - a.x()) * inv_area,
+                             (a.x() * b.y() - a.y() * b.x()) * inv_area};
+    }};
+    Eigen::Vector3f e0{edge_coefficients(t.p1, t.p2)};
+    Eigen::Vector3f e1{edge_coefficients(t.p2, t.p0)};
+    Eigen::Vector3f e2{edge_coefficients(t.p0, t.p1)};
+
+    Eigen::Vector2f min{t.p0.cwiseMin(t.p1).cwiseMin(t.p2)};
+    Eigen::Vector2f max{t.p0.cwiseMax(t.p1).cwiseMax(t.p2)};
+    int u_begin = std::max(tile_u, int(std::floor(min.x())));
+    int u_end = std::min(tile_u_end, int(std::ceil(max.x())) + 1);
+    int v_begin = std::max(tile_v, int(std::floor(min.y())));
+    int v_end = std::min(tile_v_end, int(std::ceil(max.y())) + 1);
+
+    for (int v = v_begin; v < v_end; ++v) {
+      float *depths = metric_depth_image_.ptr<float>(v);
+      uchar *body_idxs = body_idx_image_.ptr<uchar>(v);
+      float y = float(v) + 0.5f;
+      for (int u = u_begin; u < u_end; ++u) {
+        float x = float(u) + 0.5f;
+        float b0 = e0(0) * x + e0(1) * y + e0(2);
+        float b1 = e1(0) * x + e1(1) * y + e1(2);
+        float b2 = e2(0) * x + e2(1) * y + e2(2);
+        if (b0 < 0.0f || b1 < 0.0f || b2 < 0.0f) continue;
+        float depth = 1.0f / (b0 * t.inv_z0 + b1 * t.inv_z1 + b2 * t.inv_z2);
+        if (depth > z_max_) continue;
+        if (depths[u] == 0.0f || depth < depths[u]) {
+          depths[u] = depth;
+          body_idxs[u] = uchar(t.body_idx);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace icg
@@ -0,0 +1,67 @@
+#include "pyicg/thread_pool.h"
+
+namespace icg {
+
+ThreadPool::ThreadPool(int n_threads) {
+  for (int i = 1; i < n_threads; ++i)
+    workers_.emplace_back(&ThreadPool::RunWorker, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  work_condition_.notify_all();
+  for (auto &worker : workers_) worker.join();
+}
+
+void ThreadPool::ParallelFor(int n_tasks,
+                             const std::function<void(int)> &task) {
+  if (workers_.empty() || n_tasks <= 1) {
+    for (int i = 0; i < n_tasks; ++i) task(i);
+    return;
+  }
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    task_ = &task;
+    n_tasks_ = n_tasks;
+    next_task_ = 0;
+    n_busy_workers_ = int(workers_.size());
+    generation_++;
+  }
+  work_condition_.notify_all();
+  RunTasks();
+
+  std::unique_lock<std::mutex> lock{mutex_};
+  done_condition_.wait(lock, [&] { return n_busy_workers_ == 0; });
+  task_ = nullptr;
+}
+
+int ThreadPool::n_threads() const { return int(workers_.size()) + 1; }
+
+void ThreadPool::RunWorker() {
+  size_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      work_condition_.wait(
+          lock, [&] { return stop_ || generation_ != generation; });
+      if (stop_) return;
+      generation = generation_;
+    }
+    RunTasks();
+    {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      if (--n_busy_workers_ == 0) done_condition_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunTasks() {
+  for (int i = next_task_.fetch_add(1); i < n_tasks_;
+       i = next_task_.fetch_add(1))
+    (*task_)(i);
+}
+
+}  // namespace icg
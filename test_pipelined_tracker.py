@@ -0,0 +1,33 @@
+import numpy as np
+import pyicg
+from test_track_sequence import make_scene, N_FRAMES
+
+# Frames are submitted faster than they are tracked: the oldest waiting frames
+# are dropped, results of the others arrive in order
+tracker, color_camera, body, frames = make_scene()
+sequence_tracker = pyicg.SequenceTracker('sequence_tracker', tracker, color_camera)
+pipelined_tracker = pyicg.PipelinedTracker('pipelined_tracker', sequence_tracker, queue_capacity=2, drop_oldest=True)
+assert pipelined_tracker.SetUp()
+assert pipelined_tracker.Start() and pipelined_tracker.running
+for frame in frames:
+    assert pipelined_tracker.submit_frame(frame)
+assert pipelined_tracker.n_submitted_frames == N_FRAMES
+
+frame_indices = []
+while not frame_indices or frame_indices[-1] < N_FRAMES - 1:
+    result = pipelined_tracker.poll_result(timeout_ms=5000)
+    assert result is not None, 'no result within timeout'
+    frame_index, poses = result
+    assert poses is not None, f'tracking failed on frame {frame_index}'
+    assert list(poses.keys()) == ['box'] and poses['box'].shape == (4, 4)
+    frame_indices.append(frame_index)
+assert frame_indices == sorted(set(frame_indices))
+assert len(frame_indices) + pipelined_tracker.n_dropped_frames == N_FRAMES
+assert pipelined_tracker.n_dropped_results == 0
+assert pipelined_tracker.poll_result() is None
+
+pipelined_tracker.Stop()
+assert not pipelined_tracker.running
+assert not pipelined_tracker.submit_frame(frames[0])
+assert np.allclose(poses['box'], body.body2world_pose)
+print(f'tracked frames {frame_indices}, dropped {pipelined_tracker.n_dropped_frames}')
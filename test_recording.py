@@ -0,0 +1,43 @@
+from pathlib import Path
+import numpy as np
+import pyicg
+
+# Frames written through the recording writer are read back unchanged, files
+# of writers that were not closed are rejected
+TMP_DIR = Path('tmp_test')
+WIDTH, HEIGHT = 640, 480
+N_FRAMES = 5
+
+TMP_DIR.mkdir(exist_ok=True)
+path = (TMP_DIR / 'recording.bin').as_posix()
+color_camera = pyicg.DummyColorCamera('color_camera')
+color_camera.intrinsics = pyicg.Intrinsics(500.0, 500.0, WIDTH / 2, HEIGHT / 2, WIDTH, HEIGHT)
+depth_camera = pyicg.DummyDepthCamera('depth_camera')
+depth_camera.intrinsics = pyicg.Intrinsics(500.0, 500.0, WIDTH / 2, HEIGHT / 2, WIDTH, HEIGHT)
+
+writer = pyicg.RecordingWriter(path)
+assert writer.Open(color_camera, depth_camera)
+color_images = np.random.randint(0, 256, (N_FRAMES, HEIGHT, WIDTH, 3), dtype=np.uint8)
+depth_images = np.random.randint(0, 5000, (N_FRAMES, HEIGHT, WIDTH), dtype=np.uint16)
+for color_image, depth_image in zip(color_images, depth_images):
+    assert writer.AddColorImage(color_image)
+    assert writer.AddDepthImage(depth_image)
+assert writer.n_frames == N_FRAMES
+assert not pyicg.RecordingReader(path).Open(), 'recording that was not closed is accepted'
+assert writer.Close()
+
+reader = pyicg.RecordingReader(path)
+assert reader.Open()
+assert reader.n_frames == N_FRAMES
+for i in range(N_FRAMES):
+    assert np.array_equal(reader.color_image(i), color_images[i])
+    assert np.array_equal(reader.depth_image(i), depth_images[i])
+    assert i == 0 or reader.timestamp_ns(i) >= reader.timestamp_ns(i - 1)
+
+# Cameras keep the mapping of their current image once the reader is closed
+color_camera = pyicg.RecordingColorCamera('recording_color_camera', reader)
+assert color_camera.SetUp()
+assert color_camera.UpdateImage(True)
+reader.Close()
+assert np.array_equal(color_camera.image, color_images[0])
+print(f'{N_FRAMES} frames recorded and read back unchanged')
@@ -0,0 +1,61 @@
+import multiprocessing as mp
+import time
+import numpy as np
+import pyicg
+
+# A producer process publishes frames filled with their frame index, the
+# tracker side reads them through ShmColorCamera: frames have to arrive in
+# order and never be torn by the producer writing the slot being read
+SHM_NAME = '/pyicg_test_ring'
+WIDTH, HEIGHT = 640, 480
+N_FRAMES = 500
+CV_8UC3 = 16
+
+
+def produce(consumer_done):
+    ring = pyicg.ShmFrameRing(SHM_NAME)
+    assert ring.Create(WIDTH, HEIGHT, CV_8UC3, n_slots=3)
+    image = np.empty((HEIGHT, WIDTH, 3), dtype=np.uint8)
+    for i in range(N_FRAMES):
+        image[:] = i % 251
+        assert ring.Publish(image, timestamp_ns=i)
+        time.sleep(0.0005)
+    consumer_done.wait(30)
+    ring.Close()
+
+
+if __name__ == '__main__':
+    context = mp.get_context('spawn')
+    consumer_done = context.Event()
+    producer = context.Process(target=produce, args=(consumer_done,))
+    producer.start()
+
+    camera = pyicg.ShmColorCamera('shm_color', SHM_NAME)
+    camera.intrinsics = pyicg.Intrinsics(500.0, 500.0, WIDTH / 2, HEIGHT / 2, WIDTH, HEIGHT)
+    camera.color2depth_pose = np.eye(4, dtype=np.float32)
+    deadline = time.time() + 10
+    while not camera.SetUp():
+        assert time.time() < deadline, 'producer did not create the ring'
+        time.sleep(0.01)
+
+    frame_index = -1
+    n_received = 0
+    while frame_index < N_FRAMES - 1:
+        assert camera.UpdateImage(True)
+        assert camera.frame_index > frame_index, 'frames out of order'
+        frame_index = camera.frame_index
+        assert camera.timestamp_ns == frame_index
+        image = camera.image
+        assert np.all(image == frame_index % 251), f'frame {frame_index} is torn'
+        n_received += 1
+
+    # Setting up again remaps the ring, the image of the old mapping is dropped
+    assert camera.SetUp()
+    assert camera.image.size == 0
+    assert camera.UpdateImage(True)
+    assert np.all(camera.image == camera.frame_index % 251)
+
+    consumer_done.set()
+    producer.join()
+    assert producer.exitcode == 0
+    print(f'received {n_received} of {N_FRAMES} frames in order, none torn')
@@ -0,0 +1,26 @@
+import numpy as np
+from test_track_sequence import make_scene, N_FRAMES
+
+# Stage latencies are measured by default and reported per stage in ms
+tracker, color_camera, body, frames = make_scene()
+assert tracker.measure_latencies
+tracker.track_sequence(color_camera, frames)
+stats = tracker.stats()
+assert 'tracking_cycle' in stats and 'correspondences/region_modality' in stats
+cycle = stats['tracking_cycle']
+assert set(cycle.keys()) == {'count', 'mean', 'p50', 'p99', 'max'}
+assert cycle['count'] == N_FRAMES
+assert 0 <= cycle['p50'] <= cycle['p99'] <= cycle['max']
+
+# Raw samples are only returned on request
+samples = tracker.stats(samples=True)['tracking_cycle']['samples']
+assert isinstance(samples, np.ndarray) and samples.shape == (N_FRAMES,)
+assert np.isclose(samples.max(), cycle['max'])
+
+# Resetting clears all stages, disabled measurements record nothing
+tracker.reset_stats()
+assert tracker.stats()['tracking_cycle']['count'] == 0
+tracker.measure_latencies = False
+tracker.track_sequence(color_camera, frames)
+assert tracker.stats()['tracking_cycle']['count'] == 0
+print('tracking_cycle latencies [ms]:', cycle)
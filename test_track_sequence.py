@@ -0,0 +1,54 @@
+from pathlib import Path
+import numpy as np
+import pyicg
+
+# Synthetic scene: a 10 cm box, 50 cm in front of the camera, drawn as a
+# bright square on a dark background
+TMP_DIR = Path('tmp_test')
+WIDTH, HEIGHT = 640, 480
+N_FRAMES = 10
+
+
+def write_box(path, size=0.1):
+    h = size / 2
+    vertices = [(x, y, z) for x in (-h, h) for y in (-h, h) for z in (-h, h)]
+    faces = [(1, 2, 4, 3), (5, 7, 8, 6), (1, 5, 6, 2), (3, 4, 8, 7), (1, 3, 7, 5), (2, 6, 8, 4)]
+    with open(path, 'w') as f:
+        f.writelines(f'v {x} {y} {z}\n' for x, y, z in vertices)
+        f.writelines(f'f {a} {b} {c}\nf {a} {c} {d}\n' for a, b, c, d in faces)
+
+
+def make_scene(prefix='', n_frames=N_FRAMES):
+    TMP_DIR.mkdir(exist_ok=True)
+    write_box(TMP_DIR / 'box.obj')
+    tracker = pyicg.Tracker(prefix + 'tracker', synchronize_cameras=False)
+    renderer_geometry = pyicg.RendererGeometry(prefix + 'renderer_geometry')
+    color_camera = pyicg.DummyColorCamera(prefix + 'color_camera')
+    color_camera.intrinsics = pyicg.Intrinsics(500.0, 500.0, WIDTH / 2, HEIGHT / 2, WIDTH, HEIGHT)
+    color_camera.color2depth_pose = np.eye(4, dtype=np.float32)
+    body = pyicg.Body('box', (TMP_DIR / 'box.obj').as_posix(), 1.0, True, True, np.eye(4))
+    body.body2world_pose = np.array([[1, 0, 0, 0], [0, 1, 0, 0], [0, 0, 1, 0.5], [0, 0, 0, 1]], dtype=np.float32)
+    renderer_geometry.AddBody(body)
+    region_model = pyicg.RegionModel(prefix + 'region_model', body, (TMP_DIR / 'box_region_model.bin').as_posix(), n_divides=2)
+    region_modality = pyicg.RegionModality(prefix + 'region_modality', body, color_camera, region_model)
+    optimizer = pyicg.Optimizer(prefix + 'optimizer')
+    optimizer.AddModality(region_modality)
+    tracker.AddOptimizer(optimizer)
+    assert tracker.SetUp()
+
+    frames = np.full((n_frames, HEIGHT, WIDTH, 3), 30, dtype=np.uint8)
+    frames[:, HEIGHT // 2 - 50:HEIGHT // 2 + 50, WIDTH // 2 - 50:WIDTH // 2 + 50] = (40, 160, 220)
+    return tracker, color_camera, body, frames
+
+
+if __name__ == '__main__':
+    tracker, color_camera, body, frames = make_scene()
+    poses = tracker.track_sequence(color_camera, frames)
+    assert list(poses.keys()) == ['box']
+    assert poses['box'].shape == (N_FRAMES, 4, 4) and poses['box'].dtype == np.float32
+    assert np.allclose(poses['box'][-1], body.body2world_pose)
+
+    # Lists of images are accepted as well
+    poses = tracker.track_sequence(color_camera, list(frames), start_modalities=False)
+    assert poses['box'].shape == (N_FRAMES, 4, 4)
+    print('track_sequence:', poses['box'][-1][:3, 3])
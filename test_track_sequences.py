@@ -0,0 +1,21 @@
+import numpy as np
+import pyicg
+from test_track_sequence import make_scene, N_FRAMES
+
+# Two workers, each with its own tracker, camera, body and renderer geometry
+parallel_tracker = pyicg.ParallelSequenceTracker('parallel_tracker')
+sequences = []
+for i in range(2):
+    tracker, color_camera, body, frames = make_scene(f'worker{i}_')
+    parallel_tracker.AddSequenceTracker(pyicg.SequenceTracker(f'sequence_tracker{i}', tracker, color_camera))
+    sequences.append(frames)
+assert parallel_tracker.SetUp()
+
+# More sequences than workers. Bodies are reset to their initial pose before
+# each sequence, so identical sequences give identical poses
+results = parallel_tracker.track_sequences(sequences + sequences[:1])
+assert len(results) == 3
+for poses in results:
+    assert poses['box'].shape == (N_FRAMES, 4, 4)
+assert np.array_equal(results[0]['box'], results[2]['box'])
+print('track_sequences:', [poses['box'][-1][:3, 3] for poses in results])
@@ -0,0 +1,44 @@
+import gc
+import numpy as np
+import pyicg
+
+# numpy -> cv::Mat: images set on cameras share the numpy buffer
+color_camera = pyicg.DummyColorCamera('color_camera')
+image = np.random.randint(0, 256, (480, 640, 3), dtype=np.uint8)
+color_camera.image = image
+assert np.shares_memory(color_camera.image, image)
+
+# The camera keeps the buffer alive once python dropped its array
+expected = image.copy()
+del image
+gc.collect()
+np.random.randint(0, 256, (480, 640, 3), dtype=np.uint8)
+assert np.array_equal(color_camera.image, expected)
+
+# Row slices keep their row step, other layouts are copied
+large_image = np.random.randint(0, 256, (600, 800, 3), dtype=np.uint8)
+color_camera.image = large_image[100:580, 100:740]
+assert np.shares_memory(color_camera.image, large_image)
+assert np.array_equal(color_camera.image, large_image[100:580, 100:740])
+color_camera.image = large_image[:480, :640, ::-1]
+assert not np.shares_memory(color_camera.image, large_image)
+assert np.array_equal(color_camera.image, large_image[:480, :640, ::-1])
+
+depth_camera = pyicg.DummyDepthCamera('depth_camera')
+depth_image = np.random.randint(0, 5000, (480, 640), dtype=np.uint16)
+depth_camera.image = depth_image
+assert np.shares_memory(depth_camera.image, depth_image)
+print('numpy images are shared with cameras without copy')
+
+# cv::Mat -> numpy: returned arrays are views that own a reference on the Mat
+view = color_camera.image
+assert view.base is not None
+color_camera.image = np.zeros((480, 640, 3), dtype=np.uint8)
+gc.collect()
+assert np.array_equal(view, large_image[:480, :640, ::-1])
+
+# Every access returns a view on the same buffer instead of a copy
+first_view = color_camera.image
+second_view = color_camera.image
+assert first_view is not second_view and np.shares_memory(first_view, second_view)
+print('camera images are returned to numpy without copy')